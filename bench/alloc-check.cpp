@@ -0,0 +1,68 @@
+// builds a large schema, then parses a 10k-token command line (for the second time, after a reset)
+// with every heap allocation counted. exits with a non-zero status if parseCmd allocated anything,
+// which fails the build when this is run as part of it (see CMD_ARGS_ALLOC_CHECK in CMakeLists.txt)
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+#include "cmd-args.hpp"
+using namespace CmdArgs;
+
+static bool counting{false};
+static size_t allocations{0};
+
+void *operator new(size_t size) {
+    if (counting) ++allocations;
+    if (void *ptr = std::malloc(size != 0 ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+void operator delete(void *ptr) noexcept {
+    std::free(ptr);
+}
+void operator delete(void *ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+int main() {
+    const int optionCount{1500};
+    const int tokenCount{10000};
+
+    // half of the options are flags and the other half take numbers
+    ArgParser parser;
+    std::vector<std::string> names;
+    for (int i{0}; i < optionCount; ++i) {
+        names.push_back("a-fairly-long-option-name-" + std::to_string(i));
+        if (i % 2 == 0) { parser.add<FlagArg>("", names.back(), "a flag argument"); }
+        else if (i % 4 == 1) { parser.add<ValueArg<int>>("", names.back(), "an int argument"); }
+        else { parser.add<ValueArg<double>>("", names.back(), "a double argument", 0.5); }
+    }
+    parser.freeze();
+
+    // a mix of flags, numeric options with their values, and tokens that aren't names at all
+    std::vector<std::string> tokens{"alloc-check"};
+    for (int i{0}; static_cast<int>(tokens.size()) <= tokenCount; ++i) {
+        const std::string &name{names[i % optionCount]};
+        if (i % 3 == 2) { tokens.push_back("--not-a-registered-option-name-" + std::to_string(i)); }
+        else if (i % optionCount % 2 == 0) { tokens.push_back("--" + name); }
+        else {
+            tokens.push_back("--" + name);
+            tokens.push_back(i % optionCount % 4 == 1 ? std::to_string(i * 7919) : "0.0625e3");
+        }
+    }
+    std::vector<const char *> argv;
+    for (const auto &token : tokens) argv.push_back(token.c_str());
+
+    // the tokens that aren't names are kept in rest(), which holds on to its memory when the
+    // parser is reset, so that's allocated by parsing the command once before counting
+    parser.parseCmd(static_cast<int>(argv.size()), argv.data());
+    parser.reset();
+
+    counting = true;
+    parser.parseCmd(static_cast<int>(argv.size()), argv.data());
+    counting = false;
+
+    std::printf("parsed %zu tokens against %d options with %zu allocation(s)\n", argv.size() - 1,
+        optionCount, allocations);
+    return allocations == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
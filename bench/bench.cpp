@@ -0,0 +1,272 @@
+// benchmarks for the paths that matter most: parsing commands of different sizes against small and
+// large schemas, converting each built-in type, adding arguments, and creating help messages.
+// every benchmark runs a fixed number of iterations, a few times over, and reports the fastest
+// run along with how many heap allocations each iteration made. the peak RSS of the whole run is
+// printed at the end. build this in release mode (-DCMAKE_BUILD_TYPE=Release), or the numbers
+// won't mean much. pass a string as the only argument to run just the benchmarks containing it
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+#include "cmd-args.hpp"
+using namespace CmdArgs;
+
+static bool counting{false};
+static size_t allocations{0};
+
+void *operator new(size_t size) {
+    if (counting) ++allocations;
+    if (void *ptr = std::malloc(size != 0 ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+void operator delete(void *ptr) noexcept {
+    std::free(ptr);
+}
+void operator delete(void *ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+// results are added to this so the compiler can't throw the work away
+static volatile size_t sink{0};
+
+static const char *filter{nullptr};
+
+// runs body iterations times per run, and prints the fastest of a few runs. setup is called
+// (without being timed) before each run. tokens is how many tokens each iteration parses (0 if it
+// isn't a parse), for the ns/token column
+template <typename Setup, typename Body>
+static void run(const std::string &name, size_t iterations, size_t tokens, Setup setup,
+    Body body) {
+    if (filter != nullptr && name.find(filter) == std::string::npos) return;
+    const int runs{5};
+    double best{0};
+    size_t bestAllocations{0};
+    for (int r{0}; r < runs; ++r) {
+        setup();
+        allocations = 0;
+        counting = true;
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t i{0}; i < iterations; ++i) body();
+        const auto stop = std::chrono::steady_clock::now();
+        counting = false;
+        const double ns{std::chrono::duration<double, std::nano>(stop - start).count()};
+        if (r == 0 || ns < best) {
+            best = ns;
+            bestAllocations = allocations;
+        }
+    }
+
+    const double perIteration{best / static_cast<double>(iterations)};
+    std::printf("%-48s %12.1f", name.c_str(), perIteration);
+    if (tokens != 0) { std::printf(" %10.2f", perIteration / static_cast<double>(tokens)); }
+    else std::printf(" %10s", "-");
+    std::printf(" %12.2f\n",
+        static_cast<double>(bestAllocations) / static_cast<double>(iterations));
+}
+template <typename Body>
+static void run(const std::string &name, size_t iterations, size_t tokens, Body body) {
+    run(name, iterations, tokens, [] {}, body);
+}
+
+// the same kind of schema as alloc-check: half flags, a quarter ints, and a quarter doubles
+static std::vector<std::string> optionNames(int optionCount) {
+    std::vector<std::string> names;
+    for (int i{0}; i < optionCount; ++i) {
+        names.push_back("a-fairly-long-option-name-" + std::to_string(i));
+    }
+    return names;
+}
+static void addOptions(ArgParser &parser, const std::vector<std::string> &names) {
+    for (size_t i{0}; i < names.size(); ++i) {
+        if (i % 2 == 0) { parser.add<FlagArg>("", names[i], "a flag argument"); }
+        else if (i % 4 == 1) { parser.add<ValueArg<int>>("", names[i], "an int argument"); }
+        else { parser.add<ValueArg<double>>("", names[i], "a double argument", 0.5); }
+    }
+}
+
+// a mix of flags, numeric options with their values, and tokens that aren't names at all
+static std::vector<std::string> commandTokens(const std::vector<std::string> &names,
+    size_t tokenCount) {
+    std::vector<std::string> tokens{"bench"};
+    for (size_t i{0}; tokens.size() <= tokenCount; ++i) {
+        const size_t option{i % names.size()};
+        // an option that needs a value is only used if there's room left for the value
+        const bool roomForValue{tokens.size() + 1 <= tokenCount};
+        if (i % 3 == 2 || (option % 2 != 0 && !roomForValue)) {
+            tokens.push_back("--not-a-registered-option-name-" + std::to_string(i));
+        }
+        else if (option % 2 == 0) { tokens.push_back("--" + names[option]); }
+        else {
+            tokens.push_back("--" + names[option]);
+            tokens.push_back(option % 4 == 1 ? std::to_string(i * 7919) : "0.0625e3");
+        }
+    }
+    return tokens;
+}
+
+static void benchParse(int optionCount, size_t tokenCount) {
+    const std::vector<std::string> names{optionNames(optionCount)};
+    ArgParser parser;
+    addOptions(parser, names);
+    parser.freeze();
+
+    const std::vector<std::string> tokens{commandTokens(names, tokenCount)};
+    std::vector<const char *> argv;
+    for (const auto &token : tokens) argv.push_back(token.c_str());
+
+    const std::string name{"parseCmd " + std::to_string(optionCount) + " options, "
+                           + std::to_string(tokenCount) + " tokens"};
+    run(name, std::max<size_t>(1, 1000000 / tokenCount), tokenCount, [&] {
+        parser.reset();
+        parser.parseCmd(static_cast<int>(argv.size()), argv.data());
+        sink = sink + parser.setCount();
+    });
+}
+
+// one list argument repeated over and over (--id 0 --id 1 ...), so every occurrence appends to
+// the same list
+static void benchRepeatedList(size_t occurrences) {
+    ArgParser parser;
+    parser.add<ListArg<int>>("", "id", "a list argument");
+    parser.freeze();
+
+    std::vector<std::string> tokens{"bench"};
+    for (size_t i{0}; i < occurrences; ++i) {
+        tokens.push_back("--id");
+        tokens.push_back(std::to_string(i));
+    }
+    std::vector<const char *> argv;
+    for (const auto &token : tokens) argv.push_back(token.c_str());
+
+    run("parseCmd repeated list, " + std::to_string(occurrences) + " occurrences",
+        std::max<size_t>(1, 100000 / occurrences), 2 * occurrences, [&] {
+            parser.reset();
+            parser.parseCmd(static_cast<int>(argv.size()), argv.data());
+            sink = sink + parser.setCount();
+        });
+}
+
+// converts a fixed set of strings over and over
+template <typename T>
+static void benchConversion(const std::string &typeName, const std::vector<std::string> &inputs) {
+    run("stringToType<" + typeName + ">", 1000000, 0, [&] {
+        static size_t i{0};
+        const T value = stringToType<T>(inputs[i++ % inputs.size()]);
+        sink = sink + static_cast<size_t>(sizeof(value));
+    });
+}
+
+// creates parsers ahead of time, so the runs only time what they're measuring
+static std::vector<ArgParser> makeParsers(size_t count, Storage storage,
+    const std::vector<std::string> *names) {
+    std::vector<ArgParser> parsers;
+    parsers.reserve(count);
+    for (size_t i{0}; i < count; ++i) {
+        parsers.emplace_back(storage);
+        if (names != nullptr) addOptions(parsers.back(), *names);
+    }
+    return parsers;
+}
+
+// each iteration is a single add(), into one of a few parsers that each end up with every option
+static void benchAdd(int optionCount, Storage storage, const char *storageName) {
+    const std::vector<std::string> names{optionNames(optionCount)};
+    const size_t parserCount{std::max<size_t>(1, 3000 / names.size())};
+    std::vector<ArgParser> parsers;
+    size_t i{0};
+    run("add() " + std::to_string(optionCount) + " options, " + storageName,
+        parserCount * names.size(), 0,
+        [&] {
+            parsers = makeParsers(parserCount, storage, nullptr);
+            i = 0;
+        },
+        [&] {
+            ArgParser &parser = parsers[i / names.size()];
+            const size_t option{i++ % names.size()};
+            if (option % 2 == 0) { parser.add<FlagArg>("", names[option], "a flag argument"); }
+            else parser.add<ValueArg<int>>("", names[option], "an int argument", 1);
+        });
+}
+
+static void benchHelp(int optionCount) {
+    const std::vector<std::string> names{optionNames(optionCount)};
+    const std::string count{std::to_string(optionCount)};
+
+    // the first help message from each parser has to measure every argument's default value
+    const size_t parserCount{std::max<size_t>(1, 3000 / names.size())};
+    std::vector<ArgParser> parsers;
+    size_t i{0};
+    run("createHelpMessage " + count + " options, first", parserCount, 0,
+        [&] {
+            parsers = makeParsers(parserCount, SHARED_STORAGE, &names);
+            i = 0;
+        },
+        [&] { sink = sink + parsers[i++].createHelpMessage().length(); });
+
+    ArgParser parser;
+    addOptions(parser, names);
+    sink = sink + parser.createHelpMessage().length();
+    run("createHelpMessage " + count + " options, cached", std::max(1, 100000 / optionCount), 0,
+        [&] { sink = sink + parser.createHelpMessage().length(); });
+}
+
+static void printPeakRss() {
+#ifdef _WIN32
+    std::printf("\npeak RSS: unavailable on this platform\n");
+#else
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    const long kib{usage.ru_maxrss / 1024}; // bytes on macOS, KiB everywhere else
+#else
+    const long kib{usage.ru_maxrss};
+#endif
+    std::printf("\npeak RSS: %ld KiB\n", kib);
+#endif
+}
+
+int main(int argc, const char **argv) {
+    if (argc > 1) filter = argv[1];
+#ifndef __OPTIMIZE__
+    std::printf("warning: this wasn't built with optimizations\n\n");
+#endif
+    std::printf("%-48s %12s %10s %12s\n", "benchmark", "ns/op", "ns/token", "allocs/op");
+
+    for (const int options : {10, 1500}) {
+        for (const size_t tokens : {size_t{10}, size_t{100}, size_t{10000}}) {
+            benchParse(options, tokens);
+        }
+    }
+
+    for (const size_t occurrences : {size_t{100}, size_t{10000}, size_t{100000}}) {
+        benchRepeatedList(occurrences);
+    }
+
+    benchConversion<int>("int", {"0", "7", "-42", "65535", "2147483647", "-2147483648"});
+    benchConversion<unsigned>("unsigned", {"0", "7", "42", "65535", "4294967295"});
+    benchConversion<long long>("long long", {"0", "-9", "123456789012", "-9223372036854775807"});
+    benchConversion<unsigned long long>("unsigned long long",
+        {"0", "9", "123456789012", "18446744073709551615"});
+    benchConversion<float>("float", {"0", "0.5", "-3.25", "1e10", "3.4028235e38"});
+    benchConversion<double>("double", {"0", "0.0625e3", "-2.5", "3.141592653589793", "1e-300"});
+    benchConversion<long double>("long double", {"0", "0.5", "-2.75", "1.0000000000000000001"});
+    benchConversion<bool>("bool", {"true", "false", "1", "0", "TRUE"});
+    benchConversion<std::string>("std::string", {"", "short", "a value that needs the heap"});
+
+    for (const int options : {10, 1500}) {
+        benchAdd(options, SHARED_STORAGE, "shared storage");
+        benchAdd(options, ARENA_STORAGE, "arena storage");
+    }
+
+    for (const int options : {10, 1500}) benchHelp(options);
+
+    printPeakRss();
+    return EXIT_SUCCESS;
+}
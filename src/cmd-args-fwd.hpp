@@ -0,0 +1,51 @@
+/*
+ *    cmd-args forward declarations
+ *    https://github.com/JustASideQuestNPC/cmd-args
+ *
+ *    Copyright (C) 2023 Joseph Williams
+ *
+ *    This software may be modified and distributed under the terms of
+ *    the MIT license. See the LICENSE file for details.
+ */
+
+// declares the types in cmd-args.hpp without defining any of them, for headers that only need to
+// pass parsers and arguments around by pointer or reference. it doesn't include anything, so it
+// costs next to nothing to include. files that actually use the types still need cmd-args.hpp
+#ifndef CMD_ARGS_FWD_HPP
+#define CMD_ARGS_FWD_HPP
+
+namespace CmdArgs {
+class StringView;
+class Description;
+class Argument;
+template <typename T>
+class TypedArgument;
+template <typename T>
+class ValueArg;
+template <typename T>
+class ImplicitArg;
+class FlagArg;
+template <typename T>
+class ListArg;
+struct Delimiter;
+template <typename E>
+class ChoiceArg;
+
+enum Storage : int;
+enum ConstraintCount : int;
+class ArgParser;
+class ParseResult;
+class ReloadableResult;
+struct ParseError;
+class ParseStatus;
+// these two are only defined when CMD_ARGS_STATS is on
+struct ParseStats;
+class ParseHooks;
+class TokenSpan;
+class ShellTokens;
+class CompletionIndex;
+template <typename... Args>
+class StaticArgParser;
+}
+
+#endif
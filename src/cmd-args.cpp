@@ -0,0 +1,21 @@
+// the compiled part of the cmd-args library. this instantiates the argument types for every value
+// type in CMD_ARGS_VALUE_TYPES and CMD_ARGS_LIST_TYPES once, so the files that use them (built with
+// CMD_ARGS_COMPILED, which linking against the library sets) don't each have to
+#include "cmd-args.hpp"
+
+#if !CMD_ARGS_COMPILED
+#error "cmd-args.cpp has to be built with CMD_ARGS_COMPILED defined as 1"
+#endif
+
+namespace CmdArgs {
+#define CMD_ARGS_INSTANTIATE_TYPED_(T) template class TypedArgument<T>;
+#define CMD_ARGS_INSTANTIATE_VALUE_(T) \
+    template class ValueArg<T>; \
+    template class ImplicitArg<T>;
+#define CMD_ARGS_INSTANTIATE_LIST_(T) \
+    template class TypedArgument<std::vector<T>>; \
+    template class ListArg<T>;
+CMD_ARGS_LIST_TYPES(CMD_ARGS_INSTANTIATE_TYPED_)
+CMD_ARGS_VALUE_TYPES(CMD_ARGS_INSTANTIATE_VALUE_)
+CMD_ARGS_LIST_TYPES(CMD_ARGS_INSTANTIATE_LIST_)
+}
@@ -29,388 +29,5463 @@
 #pragma clang diagnostic push
 #pragma ide diagnostic ignored "OCUnusedGlobalDeclarationInspection"
 
-#include <sstream>
-#include <iomanip>
-#include <map>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <cctype>
+#include <cerrno>
+#include <clocale>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
 #include <memory>
+#include <new>
+#include <istream>
+#include <ostream>
+#include <streambuf>
+#include <stdexcept>
+#include <string>
+#include <tuple>
 #include <type_traits>
 #include <utility>
 #include <vector>
 #include <algorithm>
+#include <atomic>
+#include <mutex>
+
+// used to memory-map response files
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// environment variable fallbacks read environ directly, which isn't always declared
+#if defined(__APPLE__)
+#include <crt_externs.h>
+#elif !defined(_WIN32)
+extern char **environ;
+#endif
+
+// list arguments are split with SSE2 or NEON when they're available. define either of these as 0
+// to turn them off
+#ifndef CMD_ARGS_SSE2
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CMD_ARGS_SSE2 1
+#else
+#define CMD_ARGS_SSE2 0
+#endif
+#endif
+#ifndef CMD_ARGS_NEON
+#if !CMD_ARGS_SSE2 && (defined(__ARM_NEON) || defined(__aarch64__))
+#define CMD_ARGS_NEON 1
+#else
+#define CMD_ARGS_NEON 0
+#endif
+#endif
+#if CMD_ARGS_SSE2
+#include <emmintrin.h>
+#elif CMD_ARGS_NEON
+#include <arm_neon.h>
+#endif
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+// numbers are converted with std::from_chars when the standard library has a complete one, and
+// with the hand-written parsers in CmdArgs::detail otherwise. define this as 0 to force the latter
+#if __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+#endif
+#ifndef CMD_ARGS_HAS_FROM_CHARS
+#ifdef __cpp_lib_to_chars
+#define CMD_ARGS_HAS_FROM_CHARS 1
+#else
+#define CMD_ARGS_HAS_FROM_CHARS 0
+#endif
+#endif
+
+// this is 1 when the program links against the cmd-args library (which defines it), and makes the
+// argument types for the common value types come from the library instead of being compiled into
+// every file that includes this. leave it at 0 to use the header on its own
+#ifndef CMD_ARGS_COMPILED
+#define CMD_ARGS_COMPILED 0
+#endif
+
+// define this as 1 to have parsers record ParseStats and call ParseHooks. it's off by default, and
+// none of it is compiled in unless it's turned on. it changes the layout of ArgParser and
+// ParseResult, so every file in a program has to agree on it. when linking the cmd-args library,
+// set it with the CMake option of the same name (which the library exports) instead of defining it
+#ifndef CMD_ARGS_STATS
+#define CMD_ARGS_STATS 0
+#endif
+#if CMD_ARGS_STATS
+#include <chrono>
+#endif
 
 namespace CmdArgs {
-std::string lowerString(const std::string &str) {
+inline std::string lowerString(const std::string &str) {
     std::string lowered{str};
     std::transform(lowered.begin(), lowered.end(), lowered.begin(),
         [](unsigned char c) { return std::tolower(c); });
     return lowered;
 }
 
+// a minimal non-owning view of a run of characters (std::string_view isn't available in C++11).
+// the parser uses these to look tokens up without copying them into std::strings first
+class StringView {
+public:
+    StringView() = default;
+    StringView(const char *str) : // NOLINT(google-explicit-constructor)
+        ptr{str}, len{str != nullptr ? std::strlen(str) : 0} {
+    }
+    StringView(const char *str, size_t length) : ptr{str}, len{length} {
+    }
+    StringView(const std::string &str) : // NOLINT(google-explicit-constructor)
+        ptr{str.data()}, len{str.length()} {
+    }
+
+    [[nodiscard]] const char *data() const {
+        return ptr;
+    }
+    [[nodiscard]] size_t size() const {
+        return len;
+    }
+    [[nodiscard]] size_t length() const {
+        return len;
+    }
+    [[nodiscard]] bool empty() const {
+        return len == 0;
+    }
+    [[nodiscard]] const char *begin() const {
+        return ptr;
+    }
+    [[nodiscard]] const char *end() const {
+        return ptr + len;
+    }
+    char operator[](size_t i) const {
+        return ptr[i];
+    }
+    [[nodiscard]] std::string str() const {
+        return {ptr, len};
+    }
+    // an argument's names and description used to be std::strings, so code that still reads them
+    // into one keeps compiling
+    operator std::string() const { // NOLINT(google-explicit-constructor)
+        return str();
+    }
+
+    friend bool operator==(StringView lhs, StringView rhs) {
+        return lhs.len == rhs.len && (lhs.len == 0 || std::memcmp(lhs.ptr, rhs.ptr, lhs.len) == 0);
+    }
+    friend bool operator!=(StringView lhs, StringView rhs) {
+        return !(lhs == rhs);
+    }
+    friend std::ostream &operator<<(std::ostream &stream, StringView view) {
+        return stream.write(view.ptr, static_cast<std::streamsize>(view.len));
+    }
+private:
+    const char *ptr{""};
+    size_t len{0};
+};
+
 enum Visibility {
     VISIBLE,
     HIDDEN,
     INVISIBLE
 };
 
+// fast, locale-free conversions for the built-in arithmetic types. none of these throw or
+// allocate; they return false if the whole string isn't a valid number of type T (including if it
+// would overflow T)
+namespace detail {
+// chars are technically arithmetic, but they've always been read as characters rather than numbers
 template <typename T>
-T stringToType(const std::string &str) {
-    std::istringstream convert{str};
+struct IsNumber : std::integral_constant<bool, std::is_arithmetic<T>::value
+                                               && !std::is_same<T, bool>::value
+                                               && !std::is_same<T, char>::value
+                                               && !std::is_same<T, signed char>::value
+                                               && !std::is_same<T, unsigned char>::value
+                                               && !std::is_same<T, wchar_t>::value
+                                               && !std::is_same<T, char16_t>::value
+                                               && !std::is_same<T, char32_t>::value> {
+};
+
+#if CMD_ARGS_HAS_FROM_CHARS
+template <typename T>
+bool parseNumber(const char *first, const char *last, T &out) {
+    // from_chars doesn't accept a leading '+', but stringToType always has
+    if (first != last && *first == '+') {
+        ++first;
+        if (first != last && *first == '-') return false;
+    }
+    if (first == last) return false;
+    const std::from_chars_result result = std::from_chars(first, last, out);
+    return result.ec == std::errc{} && result.ptr == last;
+}
+#else
+template <typename T>
+bool parseInteger(const char *first, const char *last, T &out) {
+    typedef typename std::make_unsigned<T>::type Unsigned;
+    bool negative{false};
+    if (first != last && (*first == '+' || *first == '-')) {
+        negative = *first == '-';
+        ++first;
+    }
+    if (first == last || (negative && std::is_unsigned<T>::value)) return false;
+
+    // the magnitude is accumulated unsigned, so the most negative value doesn't overflow
+    const Unsigned limit{static_cast<Unsigned>(
+        static_cast<Unsigned>(std::numeric_limits<T>::max()) + (negative ? 1u : 0u))};
+    Unsigned magnitude{0};
+    for (; first != last; ++first) {
+        const unsigned digit{static_cast<unsigned>(*first - '0')};
+        if (digit > 9) return false;
+        if (magnitude > (limit - digit) / 10) return false;
+        magnitude = static_cast<Unsigned>(magnitude * 10 + digit);
+    }
+
+    if (!negative || magnitude == 0) { out = static_cast<T>(magnitude); }
+    else { out = static_cast<T>(-static_cast<T>(magnitude - 1) - 1); }
+    return true;
+}
+
+inline bool matchesWord(const char *first, const char *last, const char *word) {
+    for (; first != last; ++first, ++word) {
+        if (*word == '\0' || std::tolower(static_cast<unsigned char>(*first)) != *word) {
+            return false;
+        }
+    }
+    return *word == '\0';
+}
+
+template <typename T>
+bool parseFloat(const char *first, const char *last, T &out) {
+    // the fast path is computed in (at least) double precision
+    typedef typename std::conditional<std::is_same<T, long double>::value, long double,
+        double>::type Wide;
+
+    const char *it{first};
+    bool negative{false};
+    if (it != last && (*it == '+' || *it == '-')) negative = (*it++ == '-');
+    const char *const unsignedFirst{it};
+
+    Wide value;
+    if (matchesWord(it, last, "inf") || matchesWord(it, last, "infinity")) {
+        value = std::numeric_limits<Wide>::infinity();
+        out = static_cast<T>(negative ? -value : value);
+        return true;
+    }
+    if (matchesWord(it, last, "nan")) {
+        out = std::numeric_limits<T>::quiet_NaN();
+        return true;
+    }
+
+    // up to 19 significant digits fit in the mantissa; anything past that only matters for
+    // rounding, so it's handed to the slow path
+    uint64_t mantissa{0};
+    int significantDigits{0};
+    long exponent{0};
+    bool truncated{false};
+    bool anyDigits{false};
+    auto addDigit = [&](unsigned digit, bool fractional) {
+        anyDigits = true;
+        if (significantDigits < 19) {
+            mantissa = mantissa * 10 + digit;
+            if (mantissa != 0) ++significantDigits;
+            if (fractional) --exponent;
+        }
+        else {
+            truncated = truncated || digit != 0;
+            if (!fractional) ++exponent;
+        }
+    };
+    for (; it != last && static_cast<unsigned>(*it - '0') <= 9; ++it) {
+        addDigit(static_cast<unsigned>(*it - '0'), false);
+    }
+    if (it != last && *it == '.') {
+        for (++it; it != last && static_cast<unsigned>(*it - '0') <= 9; ++it) {
+            addDigit(static_cast<unsigned>(*it - '0'), true);
+        }
+    }
+    if (!anyDigits) return false;
+
+    if (it != last && (*it == 'e' || *it == 'E')) {
+        ++it;
+        bool negativeExponent{false};
+        if (it != last && (*it == '+' || *it == '-')) negativeExponent = (*it++ == '-');
+        if (it == last) return false;
+        long explicitExponent{0};
+        for (; it != last && static_cast<unsigned>(*it - '0') <= 9; ++it) {
+            // clamped well past the point where every type over/underflows
+            if (explicitExponent < 100000) explicitExponent = explicitExponent * 10 + (*it - '0');
+        }
+        exponent += negativeExponent ? -explicitExponent : explicitExponent;
+    }
+    if (it != last) return false;
+
+    static const Wide powers[]{1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12,
+        1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    // floats are computed as floats, since rounding to double first and then to float can give a
+    // different (wrong) answer
+    const bool isFloat{std::is_same<T, float>::value};
+    const uint64_t exactMantissa{uint64_t{1} << (isFloat ? 24 : 53)};
+    const long exactExponent{isFloat ? 10 : 22};
+    if (mantissa == 0) { value = 0; }
+    else if (!truncated && mantissa <= exactMantissa && exponent >= -exactExponent
+             && exponent <= exactExponent) {
+        // both the mantissa and the power of ten are exact, so one multiply or divide gives a
+        // correctly rounded result
+        T exact{static_cast<T>(mantissa)};
+        exact = exponent < 0 ? exact / static_cast<T>(powers[-exponent])
+                             : exact * static_cast<T>(powers[exponent]);
+        value = exact;
+    }
+    else {
+        // the syntax has already been checked, so strtod only has to do the rounding. it's the one
+        // locale-aware part of this, so the decimal point is swapped for whatever it expects
+        const size_t length{static_cast<size_t>(last - unsignedFirst)};
+        char stackBuffer[64];
+        std::unique_ptr<char[]> heapBuffer;
+        char *buffer{stackBuffer};
+        if (length >= sizeof(stackBuffer)) {
+            heapBuffer.reset(new char[length + 1]);
+            buffer = heapBuffer.get();
+        }
+        const char decimalPoint{std::localeconv()->decimal_point[0]};
+        for (size_t i{0}; i < length; ++i) {
+            buffer[i] = unsignedFirst[i] == '.' ? decimalPoint : unsignedFirst[i];
+        }
+        buffer[length] = '\0';
+
+        errno = 0;
+        if (std::is_same<Wide, long double>::value) {
+            value = static_cast<Wide>(std::strtold(buffer, nullptr));
+        }
+        else if (isFloat) { value = std::strtof(buffer, nullptr); }
+        else { value = static_cast<Wide>(std::strtod(buffer, nullptr)); }
+        // from_chars treats both overflow and underflow as out of range, so this does too
+        if (errno == ERANGE) return false;
+    }
+
+    if (value > static_cast<Wide>(std::numeric_limits<T>::max())) return false;
+    out = static_cast<T>(negative ? -value : value);
+    return true;
+}
+
+template <typename T>
+bool parseNumber(const char *first, const char *last, T &out, std::true_type /* integral */) {
+    return parseInteger(first, last, out);
+}
+template <typename T>
+bool parseNumber(const char *first, const char *last, T &out, std::false_type /* integral */) {
+    return parseFloat(first, last, out);
+}
+template <typename T>
+bool parseNumber(const char *first, const char *last, T &out) {
+    return parseNumber(first, last, out, std::is_integral<T>{});
+}
+#endif
+
+inline bool parseBool(StringView str, bool &out) {
+    auto equalsIgnoringCase = [&str](const char *word) {
+        for (size_t i{0}; i < str.length(); ++i, ++word) {
+            if (*word == '\0' || std::tolower(static_cast<unsigned char>(str[i])) != *word) {
+                return false;
+            }
+        }
+        return *word == '\0';
+    };
+    if (str == "1" || equalsIgnoringCase("true")) {
+        out = true;
+        return true;
+    }
+    if (str == "0" || equalsIgnoringCase("false")) {
+        out = false;
+        return true;
+    }
+    return false;
+}
+
+template <typename T>
+T toType(const std::string &str, std::true_type /* number */) {
+    T val;
+    if (parseNumber(str.data(), str.data() + str.length(), val)) return val;
+    throw std::invalid_argument("Couldn't convert string \"" + str + "\" to type T \n");
+}
+// lets an istream read straight out of a string, without copying it (which is all an
+// istringstream would do differently)
+class ViewBuffer : public std::streambuf {
+public:
+    ViewBuffer(const char *first, const char *last) {
+        // the get area is only ever read from
+        setg(const_cast<char *>(first), const_cast<char *>(first), const_cast<char *>(last));
+    }
+};
+template <typename T>
+T toType(const std::string &str, std::false_type /* number */) {
+    ViewBuffer buffer{str.data(), str.data() + str.length()};
+    std::istream convert{&buffer};
     T val;
     if (convert >> val) { return val; }
     else { throw std::invalid_argument("Couldn't convert string \"" + str + "\" to type T \n"); }
 }
+}
+
+// converts a string to type T. numbers go through the fast parsers above and everything else is
+// read with operator>>, so specialize this (inline, if it's in a header) to support your own types.
+// numbers and bools are specialized below, so those can't be (see the note there)
+template <typename T>
+T stringToType(const std::string &str) {
+    return detail::toType<T>(str, detail::IsNumber<T>{});
+}
 // overrides for special cases
 template <>
-bool stringToType<bool>(const std::string &str) {
-    std::string lstr = lowerString(str);
-    if (lstr == "true" || lstr == "1" || lstr == "false" || lstr == "0") {
-        return lstr == "true" || lstr == "1";
-    }
-    else { throw std::invalid_argument("Couldn't convert string \"" + str + "\" to type bool\n"); }
+inline bool stringToType<bool>(const std::string &str) {
+    bool val;
+    if (detail::parseBool(str, val)) return val;
+    throw std::invalid_argument("Couldn't convert string \"" + str + "\" to type bool\n");
 }
 template <>
-std::string stringToType<std::string>(const std::string &str) {
+inline std::string stringToType<std::string>(const std::string &str) {
     return str;
 }
+// numbers never go through stringToType when arguments convert them (they're parsed straight out
+// of the token), so they're specialized here too. that makes specializing one of them yourself a
+// compile error (a redefinition) instead of something that's silently ignored. wrap the number in
+// a type of your own to convert it differently
+#define CMD_ARGS_NUMBER_STRING_TO_TYPE_(T) \
+    template <> \
+    inline T stringToType<T>(const std::string &str) { \
+        return detail::toType<T>(str, std::true_type{}); \
+    }
+CMD_ARGS_NUMBER_STRING_TO_TYPE_(short)
+CMD_ARGS_NUMBER_STRING_TO_TYPE_(unsigned short)
+CMD_ARGS_NUMBER_STRING_TO_TYPE_(int)
+CMD_ARGS_NUMBER_STRING_TO_TYPE_(unsigned)
+CMD_ARGS_NUMBER_STRING_TO_TYPE_(long)
+CMD_ARGS_NUMBER_STRING_TO_TYPE_(unsigned long)
+CMD_ARGS_NUMBER_STRING_TO_TYPE_(long long)
+CMD_ARGS_NUMBER_STRING_TO_TYPE_(unsigned long long)
+CMD_ARGS_NUMBER_STRING_TO_TYPE_(float)
+CMD_ARGS_NUMBER_STRING_TO_TYPE_(double)
+CMD_ARGS_NUMBER_STRING_TO_TYPE_(long double)
+#undef CMD_ARGS_NUMBER_STRING_TO_TYPE_
+
+namespace detail {
+// what arguments actually use to convert their values. numbers and bools are converted straight
+// out of the token, without copying it into a std::string first
+template <typename T>
+typename std::enable_if<IsNumber<T>::value, T>::type fromString(StringView str) {
+    T val;
+    if (parseNumber(str.begin(), str.end(), val)) return val;
+    throw std::invalid_argument("Couldn't convert string \"" + str.str() + "\" to type T \n");
+}
+template <typename T>
+typename std::enable_if<std::is_same<T, bool>::value, T>::type fromString(StringView str) {
+    bool val;
+    if (parseBool(str, val)) return val;
+    throw std::invalid_argument("Couldn't convert string \"" + str.str() + "\" to type bool\n");
+}
+// StringViews point straight into argv (which outlives everything in main), so they're never
+// copied at all
+template <typename T>
+typename std::enable_if<std::is_same<T, StringView>::value, T>::type fromString(StringView str) {
+    return str;
+}
+template <typename T>
+typename std::enable_if<std::is_same<T, std::string>::value, T>::type fromString(StringView str) {
+    return str.str();
+}
+template <typename T>
+typename std::enable_if<!IsNumber<T>::value && !std::is_same<T, bool>::value
+                        && !std::is_same<T, StringView>::value
+                        && !std::is_same<T, std::string>::value, T>::type fromString(
+    StringView str) {
+    return stringToType<T>(str.str());
+}
+
+// the exception-free versions of fromString, which are what arguments actually convert their
+// values with. out is only assigned to if the conversion works. only types that go through
+// stringToType can throw, so that's the only place anything has to be caught
+template <typename T>
+typename std::enable_if<IsNumber<T>::value, bool>::type tryFromString(StringView str, T &out) {
+    T val;
+    if (!parseNumber(str.begin(), str.end(), val)) return false;
+    out = val;
+    return true;
+}
+template <typename T>
+typename std::enable_if<std::is_same<T, bool>::value, bool>::type tryFromString(StringView str,
+    T &out) {
+    return parseBool(str, out);
+}
+template <typename T>
+typename std::enable_if<std::is_same<T, StringView>::value, bool>::type tryFromString(
+    StringView str, T &out) {
+    out = str;
+    return true;
+}
+template <typename T>
+typename std::enable_if<std::is_same<T, std::string>::value, bool>::type tryFromString(
+    StringView str, T &out) {
+    out.assign(str.data(), str.length());
+    return true;
+}
+template <typename T>
+typename std::enable_if<!IsNumber<T>::value && !std::is_same<T, bool>::value
+                        && !std::is_same<T, StringView>::value
+                        && !std::is_same<T, std::string>::value, bool>::type tryFromString(
+    StringView str, T &out) {
+    try {
+        out = stringToType<T>(str.str());
+    } catch (std::invalid_argument &) {
+        return false;
+    }
+    return true;
+}
+}
+
 // this is by no means perfect, but it should cover all the basic types
 template <typename T>
 std::string typeToString(const T val) {
     return std::to_string(val);
 }
 template <>
-std::string typeToString(const bool val) {
+inline std::string typeToString(const bool val) {
     return (val ? "true" : "false");
 }
 template <>
-std::string typeToString(const std::string val) { // NOLINT(performance-unnecessary-value-param)
+// NOLINTNEXTLINE(performance-unnecessary-value-param)
+inline std::string typeToString(const std::string val) {
     return val; // NOLINT(performance-no-automatic-move)
 }
+template <>
+inline std::string typeToString(const StringView val) {
+    return val.str();
+}
+
+// how values are stored in snapshots (see ArgParser::snapshot). types that can be copied byte for
+// byte (numbers and enums) are, bools are one byte that has to be 0 or 1, strings are a length
+// followed by their bytes, lists are a count followed by their elements, and anything else is
+// written with typeToString and read back with stringToType. reads take bytes off the front of in,
+// and return false if there aren't enough. an enum is copied as whatever its underlying type holds,
+// without checking that it's one of the enum's values (ChoiceArg stores the index of its choice
+// instead, so it does check)
+namespace detail {
+inline void writeRaw(std::string &out, const void *bytes, size_t count) {
+    out.append(static_cast<const char *>(bytes), count);
+}
+inline bool readRaw(StringView &in, void *bytes, size_t count) {
+    if (in.length() < count) return false;
+    std::memcpy(bytes, in.data(), count);
+    in = StringView{in.data() + count, in.length() - count};
+    return true;
+}
+inline void writeText(std::string &out, StringView text) {
+    const uint64_t length{text.length()};
+    writeRaw(out, &length, sizeof(length));
+    writeRaw(out, text.data(), text.length());
+}
+// text points into in, so nothing is copied
+inline bool readText(StringView &in, StringView &text) {
+    uint64_t length;
+    if (!readRaw(in, &length, sizeof(length)) || in.length() < length) return false;
+    text = StringView{in.data(), static_cast<size_t>(length)};
+    in = StringView{in.data() + length, in.length() - static_cast<size_t>(length)};
+    return true;
+}
+
+// plainSize is the size of the value if it's copied byte for byte, and 0 otherwise. tag tells the
+// codecs (and the types they're used for) apart in ArgParser::schemaFingerprint, so an int and a
+// float of the same size don't read each other's snapshots
+enum : uint32_t {
+    INTEGER_TAG = 1 << 8,
+    UNSIGNED_TAG = 2 << 8,
+    FLOAT_TAG = 3 << 8,
+    ENUM_TAG = 4 << 8,
+    TEXT_TAG = 5 << 8, // anything written with typeToString
+    STRING_TAG = 6 << 8,
+    STRING_VIEW_TAG = 7 << 8,
+    BOOL_TAG = 8 << 8,
+    LIST_TAG = 8 << 24 // combined with the element's tag
+};
+template <typename T>
+constexpr uint32_t arithmeticTag() {
+    return (std::is_enum<T>::value             ? ENUM_TAG
+            : std::is_floating_point<T>::value ? FLOAT_TAG
+            : std::is_signed<T>::value         ? INTEGER_TAG
+                                               : UNSIGNED_TAG)
+           | static_cast<uint32_t>(sizeof(T));
+}
+
+template <typename T, typename Enable = void>
+struct SnapshotCodec {
+    static constexpr size_t plainSize{0};
+    static constexpr uint32_t tag{TEXT_TAG};
+    static void write(std::string &out, const T &value) {
+        writeText(out, typeToString(value));
+    }
+    static bool read(StringView &in, T &value) {
+        StringView text;
+        return readText(in, text) && tryFromString(text, value);
+    }
+};
+template <typename T>
+struct SnapshotCodec<T, typename std::enable_if<std::is_arithmetic<T>::value
+                                                || std::is_enum<T>::value>::type> {
+    static constexpr size_t plainSize{sizeof(T)};
+    static constexpr uint32_t tag{arithmeticTag<T>()};
+    static void write(std::string &out, const T &value) {
+        writeRaw(out, &value, sizeof(T));
+    }
+    static bool read(StringView &in, T &value) {
+        return readRaw(in, &value, sizeof(T));
+    }
+};
+// any byte but 0 or 1 in a bool is undefined behavior, so bools aren't copied straight in
+template <>
+struct SnapshotCodec<bool> {
+    static constexpr size_t plainSize{0};
+    static constexpr uint32_t tag{BOOL_TAG};
+    static void write(std::string &out, bool value) {
+        out += static_cast<char>(value ? 1 : 0);
+    }
+    static bool read(StringView &in, bool &value) {
+        unsigned char byte;
+        if (!readRaw(in, &byte, 1) || byte > 1) return false;
+        value = byte != 0;
+        return true;
+    }
+};
+template <>
+struct SnapshotCodec<std::string> {
+    static constexpr size_t plainSize{0};
+    static constexpr uint32_t tag{STRING_TAG};
+    static void write(std::string &out, const std::string &value) {
+        writeText(out, value);
+    }
+    static bool read(StringView &in, std::string &value) {
+        StringView text;
+        if (!readText(in, text)) return false;
+        value.assign(text.data(), text.length());
+        return true;
+    }
+};
+// StringViews point into the snapshot itself, like they point into the command when it's parsed
+template <>
+struct SnapshotCodec<StringView> {
+    static constexpr size_t plainSize{0};
+    static constexpr uint32_t tag{STRING_VIEW_TAG};
+    static void write(std::string &out, const StringView &value) {
+        writeText(out, value);
+    }
+    static bool read(StringView &in, StringView &value) {
+        return readText(in, value);
+    }
+};
+template <typename T>
+struct SnapshotCodec<std::vector<T>> {
+    static constexpr size_t plainSize{0};
+    static constexpr uint32_t tag{LIST_TAG | (SnapshotCodec<T>::tag & 0xffffffu)};
+    static void write(std::string &out, const std::vector<T> &list) {
+        const uint64_t count{list.size()};
+        writeRaw(out, &count, sizeof(count));
+        for (const T &element : list) SnapshotCodec<T>::write(out, element);
+    }
+    static bool read(StringView &in, std::vector<T> &list) {
+        uint64_t count;
+        if (!readRaw(in, &count, sizeof(count))) return false;
+        list.clear();
+        for (uint64_t i{0}; i < count; ++i) {
+            T element;
+            if (!SnapshotCodec<T>::read(in, element)) return false;
+            list.push_back(std::move(element));
+        }
+        return true;
+    }
+};
+}
+
+// scanners for splitting lists and command strings. each one looks at 16 bytes at a time with SSE2
+// or NEON when they're available, and falls back to a plain loop otherwise (and for whatever's left
+// at the end)
+namespace detail {
+inline unsigned countTrailingZeros(uint64_t bits) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctzll(bits));
+#endif
+}
+inline unsigned popCount(uint64_t bits) {
+    unsigned count{0};
+    for (; bits != 0; bits &= bits - 1) ++count;
+    return count;
+}
+
+#if CMD_ARGS_SSE2
+// one bit per byte
+inline uint64_t matchMask(const char *chunk, char c) {
+    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(chunk));
+    return static_cast<uint64_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(c))));
+}
+inline uint64_t matchAnyMask(const char *chunk, const char *set, size_t setSize) {
+    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(chunk));
+    __m128i matches = _mm_setzero_si128();
+    for (size_t i{0}; i < setSize; ++i) {
+        matches = _mm_or_si128(matches, _mm_cmpeq_epi8(bytes, _mm_set1_epi8(set[i])));
+    }
+    return static_cast<uint64_t>(_mm_movemask_epi8(matches));
+}
+inline uint64_t nonDigitMask(const char *chunk) {
+    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(chunk));
+    // a byte is a digit if clamping it to ['0', '9'] doesn't change it
+    const __m128i clamped = _mm_min_epu8(_mm_max_epu8(bytes, _mm_set1_epi8('0')),
+        _mm_set1_epi8('9'));
+    return static_cast<uint64_t>(~_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, clamped)) & 0xffff);
+}
+const unsigned bitsPerByte{1};
+#elif CMD_ARGS_NEON
+// NEON doesn't have movemask, but narrowing the comparison gives four bits per byte
+inline uint64_t narrowMask(uint8x16_t matches) {
+    return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(matches), 4)), 0);
+}
+inline uint64_t matchMask(const char *chunk, char c) {
+    const uint8x16_t bytes = vld1q_u8(reinterpret_cast<const uint8_t *>(chunk));
+    return narrowMask(vceqq_u8(bytes, vdupq_n_u8(static_cast<uint8_t>(c))));
+}
+inline uint64_t matchAnyMask(const char *chunk, const char *set, size_t setSize) {
+    const uint8x16_t bytes = vld1q_u8(reinterpret_cast<const uint8_t *>(chunk));
+    uint8x16_t matches = vdupq_n_u8(0);
+    for (size_t i{0}; i < setSize; ++i) {
+        matches = vorrq_u8(matches, vceqq_u8(bytes, vdupq_n_u8(static_cast<uint8_t>(set[i]))));
+    }
+    return narrowMask(matches);
+}
+inline uint64_t nonDigitMask(const char *chunk) {
+    const uint8x16_t bytes = vld1q_u8(reinterpret_cast<const uint8_t *>(chunk));
+    return narrowMask(vcgtq_u8(vsubq_u8(bytes, vdupq_n_u8('0')), vdupq_n_u8(9)));
+}
+const unsigned bitsPerByte{4};
+#endif
+
+// returns a pointer to the first c in [first, last), or last if there isn't one
+inline const char *findByte(const char *first, const char *last, char c) {
+#if CMD_ARGS_SSE2 || CMD_ARGS_NEON
+    for (; last - first >= 16; first += 16) {
+        const uint64_t mask{matchMask(first, c)};
+        if (mask != 0) return first + countTrailingZeros(mask) / bitsPerByte;
+    }
+#endif
+    while (first != last && *first != c) ++first;
+    return first;
+}
+
+// returns a pointer to the first character in [first, last) that's also in set, or last
+inline const char *findAnyOf(const char *first, const char *last, const char *set,
+    size_t setSize) {
+#if CMD_ARGS_SSE2 || CMD_ARGS_NEON
+    for (; last - first >= 16; first += 16) {
+        const uint64_t mask{matchAnyMask(first, set, setSize)};
+        if (mask != 0) return first + countTrailingZeros(mask) / bitsPerByte;
+    }
+#endif
+    for (; first != last; ++first) {
+        for (size_t i{0}; i < setSize; ++i) {
+            if (*first == set[i]) return first;
+        }
+    }
+    return first;
+}
+
+// returns how many times c appears in [first, last)
+inline size_t countByte(const char *first, const char *last, char c) {
+    size_t count{0};
+#if CMD_ARGS_SSE2 || CMD_ARGS_NEON
+    for (; last - first >= 16; first += 16) count += popCount(matchMask(first, c));
+    count /= bitsPerByte;
+#endif
+    for (; first != last; ++first) count += *first == c;
+    return count;
+}
+
+// returns a pointer to the first character in [first, last) that isn't a digit, or last
+inline const char *skipDigits(const char *first, const char *last) {
+#if CMD_ARGS_SSE2 || CMD_ARGS_NEON
+    for (; last - first >= 16; first += 16) {
+        const uint64_t mask{nonDigitMask(first)};
+        if (mask != 0) return first + countTrailingZeros(mask) / bitsPerByte;
+    }
+#endif
+    while (first != last && static_cast<unsigned>(*first - '0') <= 9) ++first;
+    return first;
+}
+
+// converts one list element, returning false if it's invalid. integers get their own path: the
+// digit scanner finds the end of the element and validates it in the same pass, so the delimiter
+// never has to be searched for separately
+template <typename T>
+bool parseListElement(const char *&pos, const char *last, char delimiter, T &out,
+    std::true_type /* integer */) {
+    const char *start{pos};
+    if (pos != last && (*pos == '-' || *pos == '+')) ++pos;
+    const char *end{skipDigits(pos, last)};
+    pos = end;
+    if (end != last && *end != delimiter) return false;
+    return parseNumber(start, end, out);
+}
+template <typename T>
+bool parseListElement(const char *&pos, const char *last, char delimiter, T &out,
+    std::false_type /* integer */) {
+    const char *start{pos};
+    pos = findByte(pos, last, delimiter);
+    return tryFromString(StringView{start, static_cast<size_t>(pos - start)}, out);
+}
+
+// appends every element of a delimited list to out, after making room for all of them. if an
+// element can't be converted, this returns false and points badElement at it
+template <typename T>
+bool appendList(StringView list, char delimiter, std::vector<T> &out, StringView &badElement) {
+    const char *pos{list.begin()};
+    const char *const last{list.end()};
+    // the capacity at least doubles when it has to grow. reserving just what's needed would copy
+    // the whole list again for every occurrence of a repeated argument (-i 1 -i 2 ...)
+    const size_t needed{out.size() + countByte(pos, last, delimiter) + 1};
+    if (needed > out.capacity()) out.reserve(std::max(needed, 2 * out.capacity()));
+    typedef std::integral_constant<bool, IsNumber<T>::value && std::is_integral<T>::value> Integer;
+    for (;;) {
+        const char *const start{pos};
+        T val;
+        if (!parseListElement(pos, last, delimiter, val, Integer{})) {
+            badElement = {start, static_cast<size_t>(findByte(start, last, delimiter) - start)};
+            return false;
+        }
+        out.push_back(std::move(val));
+        if (pos == last) return true;
+        ++pos; // skip the delimiter
+    }
+}
+
+// bitsets of arguments, one bit per argument index, packed into 64-bit words
+inline bool testBit(const uint64_t *bits, size_t i) {
+    return ((bits[i / 64] >> (i % 64)) & 1u) != 0;
+}
+inline void setBit(uint64_t *bits, size_t i) {
+    bits[i / 64] |= uint64_t{1} << (i % 64);
+}
+inline void clearBit(uint64_t *bits, size_t i) {
+    bits[i / 64] &= ~(uint64_t{1} << (i % 64));
+}
+inline size_t countBits(const uint64_t *bits, size_t words) {
+    size_t count{0};
+    for (size_t word{0}; word < words; ++word) count += popCount(bits[word]);
+    return count;
+}
+// calls f with the index of every set bit, in order
+template <typename Function>
+void forEachBit(const uint64_t *bits, size_t words, Function f) {
+    for (size_t word{0}; word < words; ++word) {
+        for (uint64_t remaining{bits[word]}; remaining != 0; remaining &= remaining - 1) {
+            f(word * 64 + countTrailingZeros(remaining));
+        }
+    }
+}
+}
+
+namespace detail {
+inline char **environment() {
+#if defined(__APPLE__)
+    return *_NSGetEnviron();
+#elif defined(_WIN32)
+    return _environ;
+#else
+    return environ;
+#endif
+}
+}
+
+// predefinitions for friending
+class ArgParser;
+class ParseResult;
+
+// one thing that was wrong with a command, as reported by ArgParser::tryParseCmd. these are kept
+// small, and don't hold a message: ArgParser::errorMessage builds one (the same one parseCmd would
+// have thrown) only when it's asked for
+struct ParseError {
+    enum Kind : unsigned char {
+        MISSING_VALUE, // the argument needs a value, and the next token starts with a dash
+        INVALID_VALUE, // the value couldn't be converted to the argument's type
+        INVALID_ELEMENT, // an element of a list couldn't be converted (value is the element)
+        AMBIGUOUS_NAME, // an abbreviation could be more than one name (argument is npos)
+        // a response file includes itself, directly or through others (value is the chain of
+        // paths, like "a.rsp -> b.rsp -> a.rsp")
+        RESPONSE_FILE_CYCLE,
+        INVALID_ENVIRONMENT_VALUE, // token is npos, and value is the whole NAME=value variable
+        INVALID_CHOICE, // the value isn't one of a ChoiceArg's choices
+        // the rest are for constraints (see ArgParser::require), which are checked after the
+        // whole command is parsed, so their token is npos
+        MISSING_REQUIRED, // a required argument wasn't set
+        MISSING_ONE_OF, // none of a group that needs at least one was set (argument is npos)
+        MUTUALLY_EXCLUSIVE, // more than one of a group was set (argument is the second one)
+        MISSING_DEPENDENCY, // an argument was set without one it depends on
+        CONFLICTING, // an argument was set along with one it conflicts with
+        OUT_OF_RANGE // an argument's value isn't in its range
+    };
+    static constexpr size_t npos{~size_t{0}};
+
+    Kind kind{INVALID_VALUE};
+    size_t argument{npos}; // the argument's index, in the order the arguments were added
+    size_t token{npos}; // where the token is in the command, counting from 0 (after argv[0])
+    StringView value; // the value (or token) that was wrong
+    // the parser the argument belongs to, which is a subcommand's parser for errors after the
+    // subcommand's name
+    const ArgParser *parser{nullptr};
+    size_t constraint{npos}; // the constraint that was broken, in the order they were added
+};
+// what ArgParser::tryParseCmd returns: every error in the command, in the order they were found.
+// a command without any errors doesn't allocate anything
+class ParseStatus {
+public:
+    [[nodiscard]] bool ok() const {
+        return errors_.empty();
+    }
+    explicit operator bool() const {
+        return ok();
+    }
+    [[nodiscard]] const std::vector<ParseError> &errors() const {
+        return errors_;
+    }
+private:
+    friend class ArgParser;
+    std::vector<ParseError> errors_;
+};
+
+// an argument's description, as it's passed to the argument's constructor. it's copied into the
+// argument, unless it's made with literal(), which uses the text right where it is. that's for
+// text that lives as long as the program does, like a string literal (a const array can't be told
+// apart from one, so it's up to the caller)
+class Description {
+public:
+    Description(const char *chars) : // NOLINT(google-explicit-constructor)
+        text{chars} {
+    }
+    Description(const std::string &str) : // NOLINT(google-explicit-constructor)
+        text{str} {
+    }
+    Description(StringView str) : // NOLINT(google-explicit-constructor)
+        text{str} {
+    }
+
+    // text has to outlive every argument it's given to
+    static Description literal(const char *text) {
+        Description description{text};
+        description.borrowed = true;
+        return description;
+    }
+private:
+    friend class Argument;
+    StringView text;
+    bool borrowed{false};
+};
+
+namespace detail {
+class ArgArena;
+// what ArgParser::add tells the argument it's constructing on this thread. it's only set while
+// add is constructing one, so arguments that aren't made by a parser never see it
+struct AddContext {
+    ArgArena *arena; // where the names are copied to (nullptr to give the argument a buffer)
+    StringView positionalName; // empty for arguments that aren't positional, which need a name
+};
+inline AddContext *&addContext() {
+    static thread_local AddContext *context{nullptr};
+    return context;
+}
+}
+
+// base class for arguments
+class Argument {
+public:
+    Argument(const Visibility visibility, StringView shortName, StringView longName,
+        Description description) :
+        Argument(visibility, copyText(shortName, longName, description)) {
+    }
+    Argument(StringView shortName, StringView longName, Description description) :
+        Argument(VISIBLE, shortName, longName, description) {
+    }
+
+    virtual ~Argument() = default;
+
+    // these read the bitsets in the parser the argument was added to, so they're defined after it.
+    // once that parser is destroyed, they keep returning what they did right before it was
+    [[nodiscard]] bool isSet() const;
+    [[nodiscard]] bool isDefined() const;
+
+    // the names (with their dashes) and the description (unless it's a Description::literal,
+    // which is used where it is) are kept in a single buffer the argument owns. with
+    // ARENA_STORAGE, that's packed back to back with every other argument's in the parser's arena
+    // instead, where the argument itself is, so they're valid exactly as long as it is either way
+    const StringView shortName;
+    const StringView longName;
+    const StringView description;
+    const Visibility visibility;
+
+protected:
+    friend class ArgParser;
+    friend class ParseResult;
+    // whether the argument is defined before anything is parsed (because it has a default value).
+    // whether it's been set or defined by a command is kept by the parser
+    bool definedByDefault_{false};
+
+    // returned by parseValue to say what the argument should be marked as (0 means the value was
+    // invalid)
+    enum : unsigned {
+        MARK_SET = 1,
+        MARK_DEFINED = 2
+    };
+
+    // everything that changes while an argument is being parsed lives in a separate state object,
+    // so one argument can be parsed into any number of ParseResults at the same time. the state
+    // that value() reads is just the one the argument keeps for itself
+    [[nodiscard]] virtual size_t stateSize() const = 0;
+    [[nodiscard]] virtual size_t stateAlignment() const = 0;
+    virtual void constructState(void *state) const = 0; // constructs a state holding the default
+    virtual void destroyState(void *state) const = 0;
+    virtual void resetState(void *state) const = 0; // assigns the default to an existing state
+    virtual void *ownState() = 0;
+    // converts arg into state. wasSet is whether the state has already been set by an earlier
+    // token, and attached is whether arg came with the argument's name (--name=value or -j8) or
+    // from somewhere other than the command (like the environment or a config file), which means
+    // it's always a value, even if it's empty or starts with a dash. the return value is some
+    // combination of MARK_SET and MARK_DEFINED, or 0 if arg is invalid, in which case error's kind
+    // and value say why. this never throws (the parser builds messages from error when it needs
+    // to), and it can't modify the argument itself, since it might be running on several threads
+    // at once. the parser calls the override in the type that was passed to add() directly instead
+    // of through the vtable, so argument types have to friend ArgParser (like the ones here do)
+    virtual unsigned parseValue(void *state, bool wasSet, StringView arg, bool attached,
+        ParseError &error) const = 0;
+    // used instead of parseValue when the parser converts values lazily (attached means the same
+    // thing it does there). if arg can be converted later, this returns what the argument should
+    // be marked as (without converting anything), and otherwise it returns 0 to have the parser
+    // call parseValue right away. a deferred value is converted as an attached one, since it's
+    // known to be a value by then
+    [[nodiscard]] virtual unsigned deferValue(StringView, bool /* attached */) const {
+        return 0;
+    }
+    // converts the argument's value if it was deferred and hasn't been converted yet. this only
+    // looks at the parser if there's a value to convert, so it's safe after the parser is gone
+    void resolve() const;
+    // append state to a snapshot, and read it back (returning false if the snapshot is cut short
+    // or holds something the argument can't have). see detail::SnapshotCodec
+    virtual void writeSnapshot(const void *state, std::string &out) const = 0;
+    virtual bool readSnapshot(void *state, StringView &in) const = 0;
+    // the size of the state if it's written to snapshots byte for byte (and 0 if it isn't), which
+    // lets the parser copy it in and out without calling the two functions above
+    [[nodiscard]] virtual size_t plainSnapshotSize() const {
+        return 0;
+    }
+    // what kind of argument this is and how its state is written (see detail::SnapshotCodec), for
+    // ArgParser::schemaFingerprint. argument types that aren't from here can leave it at 0
+    enum : uint64_t {
+        VALUE_SNAPSHOT = uint64_t{1} << 32,
+        IMPLICIT_SNAPSHOT = uint64_t{2} << 32,
+        FLAG_SNAPSHOT = uint64_t{3} << 32,
+        LIST_SNAPSHOT = uint64_t{4} << 32,
+        CHOICE_SNAPSHOT = uint64_t{5} << 32
+    };
+    [[nodiscard]] virtual uint64_t snapshotTag() const {
+        return 0;
+    }
+
+    static unsigned fail(ParseError &error, ParseError::Kind kind, StringView value) {
+        error.kind = kind;
+        error.value = value;
+        return 0;
+    }
+    // the message for an error from parseValue
+    [[nodiscard]] std::string errorMessage(const ParseError &error) const {
+        switch (error.kind) {
+        case ParseError::MISSING_VALUE:
+            return "Command-line argument " + namesForErrors()
+                   + " requires a value but none was given\n";
+        case ParseError::INVALID_ELEMENT:
+            return "Command-line argument " + namesForErrors()
+                   + " recieved an invalid list element of \"" + error.value.str() + "\"\n";
+        case ParseError::INVALID_CHOICE:
+            return "Command-line argument " + namesForErrors() + " recieved an invalid value of \""
+                   + error.value.str() + "\" (it has to be one of " + choicesAsString() + ")\n";
+        default:
+            return "Command-line argument " + namesForErrors() + " recieved an invalid value of \""
+                   + error.value.str() + "\"\n";
+        }
+    }
+    virtual std::string getDefaultAsString() const = 0; // used for printing a help message
+    // the name of every value the argument accepts (for help messages, error messages, and shell
+    // completion), or nullptr for arguments that accept anything their type can be converted from
+    [[nodiscard]] virtual const std::vector<std::string> *choiceList() const {
+        return nullptr;
+    }
+    // the choices joined together, or an empty string if there aren't any
+    [[nodiscard]] std::string choicesAsString() const {
+        std::string joined;
+        if (const std::vector<std::string> *choices = choiceList()) {
+            for (size_t i{0}; i < choices->size(); ++i) {
+                if (i != 0) joined += ", ";
+                joined += (*choices)[i];
+            }
+        }
+        return joined;
+    }
+
+    [[nodiscard]] std::string namesForErrors() const {
+        if (shortName.empty() && longName.empty()) return "<" + positionalName.str() + ">";
+        // completely unnecessary ternary here to make error messages look a little prettier
+        return shortName.str() + (!shortName.empty() && !longName.empty() ? "/" : "")
+               + longName.str();
+    }
+private:
+    // set by ArgParser::add, and used to find the argument's state in a ParseResult. the parser
+    // clears owner when it's destroyed, and leaves what the argument was marked as in detachedSet
+    // and detachedDefined (arguments with SHARED_STORAGE can outlive their parser)
+    const ArgParser *owner{nullptr};
+    size_t index{0};
+    bool detachedSet{false};
+    bool detachedDefined{false};
+    // the value lazy conversion deferred, which stays pending until it's converted
+    mutable bool pending{false};
+    StringView pendingValue;
+    // set by ArgParser::addPositional, and used in place of the names (which are empty)
+    StringView positionalName;
+    std::unique_ptr<char[]> ownText; // the text, for arguments that aren't in an arena
+
+    struct Text {
+        StringView shortName;
+        StringView longName;
+        StringView description;
+        StringView positionalName;
+        std::unique_ptr<char[]> owned;
+    };
+    // copies the names, with their dashes, the description if it isn't borrowed, and the name
+    // from ArgParser::addPositional into the arena for ARENA_STORAGE, and into owned otherwise (so
+    // an argument with SHARED_STORAGE can outlive its parser). it's defined after the arena. this
+    // is the first thing an argument's constructor does, so an argument that ArgParser::add can't
+    // take is rejected here, before anything has been stored anywhere
+    static Text copyText(StringView shortName, StringView longName,
+        const Description &description);
+    Argument(const Visibility visibility, Text &&text) :
+        shortName{text.shortName}, longName{text.longName}, description{text.description},
+        visibility{visibility}, positionalName{text.positionalName},
+        ownText{std::move(text.owned)} {
+    }
+};
+
+// implements the state functions for arguments whose state is a single value of type T. data is
+// the argument's own state, and dv is what every new state starts out as
+template <typename T>
+class TypedArgument : public Argument {
+public:
+    typedef T ValueType;
+protected:
+    using Argument::Argument;
+    // value-initialized so arguments without a default aren't left holding garbage
+    T data{}, dv{};
+
+    [[nodiscard]] size_t stateSize() const override {
+        return sizeof(T);
+    }
+    [[nodiscard]] size_t stateAlignment() const override {
+        return alignof(T);
+    }
+    void constructState(void *state) const override {
+        new(state) T(dv);
+    }
+    void destroyState(void *state) const override {
+        static_cast<T *>(state)->~T();
+    }
+    void resetState(void *state) const override {
+        *static_cast<T *>(state) = dv;
+    }
+    void *ownState() override {
+        return &data;
+    }
+};
+
+// ValueArgs can (but don't have to) have a default value, and can be set in the commmand
+// if they are set in the command, they must be accompannied by a value (even if they have a
+// default value)
+template <typename T>
+class [[maybe_unused]] ValueArg : public TypedArgument<T> {
+public:
+    // ctors
+    ValueArg(const Visibility visibility, StringView shortName, StringView longName,
+        Description description) :
+        TypedArgument<T>(visibility, shortName, longName, description) {
+    }
+    ValueArg(const Visibility visibility, StringView shortName, StringView longName,
+        Description description, const T &defaultValue) :
+        TypedArgument<T>(visibility, shortName, longName, description) {
+        this->data = defaultValue;
+        this->dv = defaultValue;
+        this->definedByDefault_ = true;
+        hasDefault_ = true;
+    }
+    ValueArg(StringView shortName, StringView longName,
+        Description description) :
+        ValueArg(VISIBLE, shortName, longName, description) {
+    }
+    ValueArg(StringView shortName, StringView longName,
+        Description description, const T &defaultValue) :
+        ValueArg(VISIBLE, shortName, longName, description, defaultValue) {
+    }
+
+    // these return references so reading a value never copies it. if the parser converts values
+    // lazily, this is where the value is converted (the first time it's read), so this can throw
+    const T &value() const {
+        this->resolve();
+        return this->data;
+    }
+    [[nodiscard]] bool hasDefault() const {
+        return hasDefault_;
+    }
+    // returns the argument's default value
+    const T &defaultValue() const {
+        return this->dv;
+    }
+private:
+    friend class ArgParser;
+    bool hasDefault_{false};
+
+    unsigned parseValue(void *state, bool, StringView arg, bool attached,
+        ParseError &error) const override {
+        // error check for no parameter
+        if (!attached && !arg.empty() && arg[0] == '-') {
+            return this->fail(error, ParseError::MISSING_VALUE, arg);
+        }
+        T value;
+        if (!detail::tryFromString(arg, value)) {
+            return this->fail(error, ParseError::INVALID_VALUE, arg);
+        }
+        *static_cast<T *>(state) = std::move(value);
+        return Argument::MARK_SET | Argument::MARK_DEFINED;
+    }
+
+    // missing values are still reported right away
+    unsigned deferValue(StringView arg, bool attached) const override {
+        if (arg.empty() || (!attached && arg[0] == '-')) return 0;
+        return Argument::MARK_SET | Argument::MARK_DEFINED;
+    }
+
+    void writeSnapshot(const void *state, std::string &out) const override {
+        detail::SnapshotCodec<T>::write(out, *static_cast<const T *>(state));
+    }
+    bool readSnapshot(void *state, StringView &in) const override {
+        return detail::SnapshotCodec<T>::read(in, *static_cast<T *>(state));
+    }
+    size_t plainSnapshotSize() const override {
+        return detail::SnapshotCodec<T>::plainSize;
+    }
+    uint64_t snapshotTag() const override {
+        return Argument::VALUE_SNAPSHOT | detail::SnapshotCodec<T>::tag;
+    }
+
+    // *attempts* to return the default value (if it exists) as a string.
+    std::string getDefaultAsString() const override {
+        if (!hasDefault_) return "";
+        return {"=" + typeToString(this->dv)};
+    }
+};
+
+// ImplicitArgs must have a default value, but are undefined unless they appear in the command
+// if they appear in the command and are given a value, they are equal to that value,
+// otherwise they are equal to their default value
+template <typename T>
+class [[maybe_unused]] ImplicitArg : public TypedArgument<T> {
+public:
+    // ctor without default value
+    ImplicitArg(const Visibility visibility, StringView shortName,
+        StringView longName, Description description, const T &sv) :
+        TypedArgument<T>(visibility, shortName, longName, description) {
+        setValue = sv;
+    }
+    // ctor with default value
+    ImplicitArg(const Visibility visibility, StringView shortName,
+        StringView longName, Description description, const T &sv, const T &dv) :
+        TypedArgument<T>(visibility, shortName, longName, description) {
+        setValue = sv;
+        this->data = dv;
+        this->dv = dv;
+        hasDefault_ = true;
+        this->definedByDefault_ = true;
+    }
+    ImplicitArg(StringView shortName, StringView longName,
+        Description description, const T &sv) :
+        ImplicitArg(VISIBLE, shortName, longName, description, sv) {
+    }
+    ImplicitArg(StringView shortName, StringView longName,
+        Description description, const T &sv, const T &dv) :
+        ImplicitArg(VISIBLE, shortName, longName, description, sv, dv) {
+    }
+
+    // these return references so reading a value never copies it. like ValueArg::value(), this
+    // can throw if the parser converts values lazily
+    const T &value() const {
+        this->resolve();
+        return this->data;
+    }
+    const T &defaultSetValue() const {
+        return setValue;
+    }
+    [[nodiscard]] bool hasDefault() const {
+        return hasDefault_;
+    }
+    const T &defaultValue() const {
+        return this->dv;
+    }
+private:
+    friend class ArgParser;
+    T setValue;
+    bool hasDefault_{false};
+
+    unsigned parseValue(void *state, bool, StringView arg, bool attached,
+        ParseError &error) const override {
+        // set data to the default value if no value is given in the command (including when the
+        // argument is the last thing in the command). --name= (with nothing after the =) is the
+        // same as naming the argument without a value
+        if (arg.empty() || (!attached && arg[0] == '-')) {
+            *static_cast<T *>(state) = setValue;
+            return Argument::MARK_DEFINED;
+        }
+
+        T value;
+        if (!detail::tryFromString(arg, value)) {
+            return this->fail(error, ParseError::INVALID_VALUE, arg);
+        }
+        *static_cast<T *>(state) = std::move(value);
+        return Argument::MARK_SET | Argument::MARK_DEFINED;
+    }
+
+    // if there's no value, setting the argument to setValue is cheap enough to do right away
+    unsigned deferValue(StringView arg, bool attached) const override {
+        if (arg.empty() || (!attached && arg[0] == '-')) return 0;
+        return Argument::MARK_SET | Argument::MARK_DEFINED;
+    }
+
+    void writeSnapshot(const void *state, std::string &out) const override {
+        detail::SnapshotCodec<T>::write(out, *static_cast<const T *>(state));
+    }
+    bool readSnapshot(void *state, StringView &in) const override {
+        return detail::SnapshotCodec<T>::read(in, *static_cast<T *>(state));
+    }
+    size_t plainSnapshotSize() const override {
+        return detail::SnapshotCodec<T>::plainSize;
+    }
+    uint64_t snapshotTag() const override {
+        return Argument::IMPLICIT_SNAPSHOT | detail::SnapshotCodec<T>::tag;
+    }
+
+    // *attempts* to return the default value as a string.
+    std::string getDefaultAsString() const override {
+        return {"=arg(=" + typeToString(setValue) + ")"};
+    }
+};
+
+// Flag arguments can only be booleans and cannot have a default value. If a flag argument appears
+// in the command, it is equal to true, otherwise, it is equal to false.
+class [[maybe_unused]] FlagArg : public TypedArgument<bool> {
+public:
+    FlagArg(const Visibility visibility, StringView shortName, StringView longName,
+        Description description) :
+        TypedArgument<bool>(visibility, shortName, longName, description) {
+        definedByDefault_ = true;
+    }
+    FlagArg(StringView shortName, StringView longName,
+        Description description) :
+        FlagArg(VISIBLE, shortName, longName, description) {
+    }
+
+    [[nodiscard]] bool value() const {
+        return data;
+    }
+private:
+    friend class ArgParser;
+    // an attached value can turn a flag off (--verbose=false, or false or 0 in the environment or
+    // a config file), and an empty one turns it on
+    unsigned parseValue(void *state, bool, StringView arg, bool attached,
+        ParseError &error) const override {
+        bool value{true};
+        if (attached && !arg.empty() && !detail::parseBool(arg, value)) {
+            return fail(error, ParseError::INVALID_VALUE, arg);
+        }
+        *static_cast<bool *>(state) = value;
+        return MARK_SET;
+    }
+
+    void writeSnapshot(const void *state, std::string &out) const override {
+        detail::SnapshotCodec<bool>::write(out, *static_cast<const bool *>(state));
+    }
+    bool readSnapshot(void *state, StringView &in) const override {
+        return detail::SnapshotCodec<bool>::read(in, *static_cast<bool *>(state));
+    }
+    size_t plainSnapshotSize() const override {
+        return detail::SnapshotCodec<bool>::plainSize;
+    }
+    uint64_t snapshotTag() const override {
+        return FLAG_SNAPSHOT | detail::SnapshotCodec<bool>::tag;
+    }
+    // flags never have a default value, but this is still required for the help message
+    std::string getDefaultAsString() const override {
+        return "";
+    }
+};
+
+// wraps a list delimiter so it can't be mistaken for a default value
+struct Delimiter {
+    explicit Delimiter(char c) : c{c} {
+    }
+    char c;
+};
+
+// ListArgs hold a list of values of type T, which are given as one delimited token (--ids 1,2,3),
+// by naming the argument more than once (--ids 1 --ids 2), or both. they can optionally have a
+// default list, which is replaced (not appended to) by the values in the command
+template <typename T>
+class [[maybe_unused]] ListArg : public TypedArgument<std::vector<T>> {
+public:
+    ListArg(const Visibility visibility, StringView shortName, StringView longName,
+        Description description, const Delimiter delimiter = Delimiter{','}) :
+        TypedArgument<std::vector<T>>(visibility, shortName, longName, description),
+        delim{delimiter.c} {
+    }
+    ListArg(const Visibility visibility, StringView shortName, StringView longName,
+        Description description, const std::vector<T> &defaultValue,
+        const Delimiter delimiter = Delimiter{','}) :
+        TypedArgument<std::vector<T>>(visibility, shortName, longName, description),
+        delim{delimiter.c} {
+        this->data = defaultValue;
+        this->dv = defaultValue;
+        this->definedByDefault_ = true;
+        hasDefault_ = true;
+    }
+    ListArg(StringView shortName, StringView longName,
+        Description description, const Delimiter delimiter = Delimiter{','}) :
+        ListArg(VISIBLE, shortName, longName, description, delimiter) {
+    }
+    ListArg(StringView shortName, StringView longName,
+        Description description, const std::vector<T> &defaultValue,
+        const Delimiter delimiter = Delimiter{','}) :
+        ListArg(VISIBLE, shortName, longName, description, defaultValue, delimiter) {
+    }
+
+    const std::vector<T> &value() const {
+        return this->data;
+    }
+    [[nodiscard]] bool hasDefault() const {
+        return hasDefault_;
+    }
+    const std::vector<T> &defaultValue() const {
+        return this->dv;
+    }
+    [[nodiscard]] char delimiter() const {
+        return delim;
+    }
+private:
+    friend class ArgParser;
+    bool hasDefault_{false};
+    char delim;
+
+    // an empty attached value (--ids=) is an empty list
+    unsigned parseValue(void *state, bool wasSet, StringView arg, bool attached,
+        ParseError &error) const override {
+        if (!attached && (arg.empty() || arg[0] == '-')) {
+            return this->fail(error, ParseError::MISSING_VALUE, arg);
+        }
+
+        // the first time the argument appears, its values replace the default. they're appended
+        // after the old ones either way, so that if an element is invalid, cutting them off again
+        // leaves the list exactly as it was
+        std::vector<T> &list = *static_cast<std::vector<T> *>(state);
+        const size_t oldSize{list.size()};
+        StringView badElement;
+        if (!arg.empty() && !detail::appendList(arg, delim, list, badElement)) {
+            list.erase(list.begin() + static_cast<std::ptrdiff_t>(oldSize), list.end());
+            return this->fail(error, ParseError::INVALID_ELEMENT, badElement);
+        }
+        if (!wasSet) list.erase(list.begin(), list.begin() + static_cast<std::ptrdiff_t>(oldSize));
+        return Argument::MARK_SET | Argument::MARK_DEFINED;
+    }
+
+    void writeSnapshot(const void *state, std::string &out) const override {
+        detail::SnapshotCodec<std::vector<T>>::write(out,
+            *static_cast<const std::vector<T> *>(state));
+    }
+    bool readSnapshot(void *state, StringView &in) const override {
+        return detail::SnapshotCodec<std::vector<T>>::read(in,
+            *static_cast<std::vector<T> *>(state));
+    }
+    uint64_t snapshotTag() const override {
+        return Argument::LIST_SNAPSHOT | detail::SnapshotCodec<std::vector<T>>::tag;
+    }
+
+    std::string getDefaultAsString() const override {
+        if (!hasDefault_) return "";
+        std::string joined{"="};
+        for (size_t i{0}; i < this->dv.size(); ++i) {
+            if (i != 0) joined += delim;
+            joined += typeToString(this->dv[i]);
+        }
+        return joined;
+    }
+};
+
+// ChoiceArgs hold a value of type E (usually an enum), which is set by naming them in the command
+// followed by the name of one of their choices (--codec zstd). they're constructed with the names
+// and values of their choices, and they can optionally have a default value, which has to be one
+// of them. the choices are put in a small perfect hash table when the argument is constructed, so
+// converting a value takes one hash and one comparison, no matter how many choices there are
+template <typename E>
+class [[maybe_unused]] ChoiceArg : public TypedArgument<E> {
+public:
+    typedef std::vector<std::pair<std::string, E>> Choices;
+
+    ChoiceArg(const Visibility visibility, StringView shortName,
+        StringView longName, Description description, const Choices &choices) :
+        TypedArgument<E>(visibility, shortName, longName, description) {
+        setChoices(choices);
+    }
+    ChoiceArg(const Visibility visibility, StringView shortName,
+        StringView longName, Description description, const Choices &choices,
+        const E &defaultValue) :
+        TypedArgument<E>(visibility, shortName, longName, description) {
+        setChoices(choices);
+        defaultChoice = findValue(defaultValue);
+        if (defaultChoice == names.size()) {
+            throw std::invalid_argument("The default value of command-line argument "
+                                        + this->namesForErrors() + " isn't one of its choices\n");
+        }
+        this->data = defaultValue;
+        this->dv = defaultValue;
+        this->definedByDefault_ = true;
+    }
+    ChoiceArg(StringView shortName, StringView longName,
+        Description description, const Choices &choices) :
+        ChoiceArg(VISIBLE, shortName, longName, description, choices) {
+    }
+    ChoiceArg(StringView shortName, StringView longName,
+        Description description, const Choices &choices, const E &defaultValue) :
+        ChoiceArg(VISIBLE, shortName, longName, description, choices, defaultValue) {
+    }
+
+    const E &value() const {
+        return this->data;
+    }
+    [[nodiscard]] bool hasDefault() const {
+        return defaultChoice != names.size();
+    }
+    const E &defaultValue() const {
+        return this->dv;
+    }
+    // the names of the choices, in the order they were given
+    [[nodiscard]] const std::vector<std::string> &choiceNames() const {
+        return names;
+    }
+    // the name of the choice with that value (or an empty string if there isn't one)
+    [[nodiscard]] const std::string &nameOf(const E &value) const {
+        static const std::string none;
+        const size_t i{findValue(value)};
+        return i != names.size() ? names[i] : none;
+    }
+private:
+    friend class ArgParser;
+    std::vector<std::string> names;
+    std::vector<E> values;
+    size_t defaultChoice{0};
+    // each slot holds the index of the only choice that can hash to it, or EMPTY. seed is picked
+    // (and the table grown if it has to be) until every choice gets a slot of its own
+    enum : uint32_t { EMPTY = ~uint32_t{0} };
+    std::vector<uint32_t> slots;
+    uint32_t seed{0};
+    uint32_t mask{0};
+
+    // FNV-1a, followed by a mixer so that each seed spreads the names out differently
+    static uint32_t hashChoice(StringView name, uint32_t seed) {
+        uint32_t hash{2166136261u};
+        for (const char c : name) {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 16777619u;
+        }
+        hash ^= seed;
+        hash ^= hash >> 16;
+        hash *= 0x7feb352du;
+        hash ^= hash >> 15;
+        hash *= 0x846ca68bu;
+        return hash ^ (hash >> 16);
+    }
+
+    void setChoices(const Choices &choices) {
+        if (choices.empty()) {
+            throw std::invalid_argument("Command-line argument " + this->namesForErrors()
+                                        + " must have at least one choice\n");
+        }
+        names.reserve(choices.size());
+        values.reserve(choices.size());
+        for (const auto &choice : choices) {
+            if (std::find(names.begin(), names.end(), choice.first) != names.end()) {
+                throw std::invalid_argument("Command-line argument " + this->namesForErrors()
+                                            + " has more than one choice named \"" + choice.first
+                                            + "\"\n");
+            }
+            names.push_back(choice.first);
+            values.push_back(choice.second);
+        }
+        defaultChoice = names.size();
+
+        // a table twice the size of the choices usually only needs a few seeds, and growing it
+        // every so often guarantees that the search ends (names can only share a slot at every
+        // size if their hashes are identical, which the size limit catches)
+        size_t capacity{2};
+        while (capacity < names.size() * 2) capacity *= 2;
+        for (uint32_t attempt{1};; ++attempt) {
+            if (attempt % 32 == 0) capacity *= 2;
+            if (capacity > (size_t{1} << 20)) {
+                throw std::invalid_argument("Couldn't build a lookup table for the choices of "
+                                            "command-line argument " + this->namesForErrors()
+                                            + "\n");
+            }
+            if (tryBuildTable(attempt, capacity)) return;
+        }
+    }
+    bool tryBuildTable(uint32_t trySeed, size_t capacity) {
+        slots.assign(capacity, EMPTY);
+        const uint32_t tryMask{static_cast<uint32_t>(capacity - 1)};
+        for (size_t i{0}; i < names.size(); ++i) {
+            uint32_t &slot = slots[hashChoice(names[i], trySeed) & tryMask];
+            if (slot != EMPTY) return false;
+            slot = static_cast<uint32_t>(i);
+        }
+        seed = trySeed;
+        mask = tryMask;
+        return true;
+    }
+
+    size_t findValue(const E &value) const {
+        return static_cast<size_t>(std::find(values.begin(), values.end(), value)
+                                   - values.begin());
+    }
+
+    unsigned parseValue(void *state, bool, StringView arg, bool attached,
+        ParseError &error) const override {
+        if (!attached && !arg.empty() && arg[0] == '-') {
+            return this->fail(error, ParseError::MISSING_VALUE, arg);
+        }
+        const uint32_t i{slots[hashChoice(arg, seed) & mask]};
+        if (i == EMPTY || !(StringView{names[i]} == arg)) {
+            return this->fail(error, ParseError::INVALID_CHOICE, arg);
+        }
+        *static_cast<E *>(state) = values[i];
+        return Argument::MARK_SET | Argument::MARK_DEFINED;
+    }
+
+    // stored as the index of the choice, so E doesn't have to be anything in particular. a value
+    // that isn't a choice (like the value-initialized one an argument without a default starts
+    // with) is stored as the number of choices, and read back as the default
+    void writeSnapshot(const void *state, std::string &out) const override {
+        const uint32_t i{static_cast<uint32_t>(findValue(*static_cast<const E *>(state)))};
+        detail::writeRaw(out, &i, sizeof(i));
+    }
+    bool readSnapshot(void *state, StringView &in) const override {
+        uint32_t i;
+        if (!detail::readRaw(in, &i, sizeof(i)) || i > names.size()) return false;
+        *static_cast<E *>(state) = i < names.size() ? values[i] : this->dv;
+        return true;
+    }
+    // the tag of E still tells ChoiceArgs of different types apart
+    uint64_t snapshotTag() const override {
+        return Argument::CHOICE_SNAPSHOT | detail::SnapshotCodec<E>::tag;
+    }
+
+    std::string getDefaultAsString() const override {
+        if (!hasDefault()) return "";
+        return {"=" + names[defaultChoice]};
+    }
+    const std::vector<std::string> *choiceList() const override {
+        return &names;
+    }
+};
+
+#if CMD_ARGS_COMPILED
+// the value types that the library compiles every argument type for. anything else still works,
+// it's just compiled wherever it's used
+#define CMD_ARGS_LIST_TYPES(X) \
+    X(int) X(unsigned) X(long) X(unsigned long) X(long long) X(unsigned long long) X(float) \
+    X(double) X(long double) X(std::string) X(StringView)
+#define CMD_ARGS_VALUE_TYPES(X) CMD_ARGS_LIST_TYPES(X) X(bool)
+
+// FlagArg has already instantiated TypedArgument<bool>, so that one is left to FlagArg
+#define CMD_ARGS_EXTERN_TYPED_(T) extern template class TypedArgument<T>;
+#define CMD_ARGS_EXTERN_VALUE_(T) \
+    extern template class ValueArg<T>; \
+    extern template class ImplicitArg<T>;
+#define CMD_ARGS_EXTERN_LIST_(T) \
+    extern template class TypedArgument<std::vector<T>>; \
+    extern template class ListArg<T>;
+CMD_ARGS_LIST_TYPES(CMD_ARGS_EXTERN_TYPED_)
+CMD_ARGS_VALUE_TYPES(CMD_ARGS_EXTERN_VALUE_)
+CMD_ARGS_LIST_TYPES(CMD_ARGS_EXTERN_LIST_)
+#undef CMD_ARGS_EXTERN_TYPED_
+#undef CMD_ARGS_EXTERN_VALUE_
+#undef CMD_ARGS_EXTERN_LIST_
+#endif
+
+// flat open-addressing hash table over every short and long name, built by ArgParser::freeze().
+// slots are kept small so a lookup is one hash plus (usually) a single probe into one cache line,
+// and the names themselves are only compared once the hash and length already match
+class NameIndex {
+public:
+    template <typename ArgPtr>
+    void build(const std::vector<ArgPtr> &args) {
+        size_t nameCount{0};
+        for (const auto &arg : args) {
+            nameCount += (!arg->shortName.empty()) + (!arg->longName.empty());
+        }
+
+        // keep the load factor at or below 50% so probe sequences stay short
+        size_t capacity{8};
+        while (capacity < nameCount * 2) capacity *= 2;
+        slots.assign(capacity, Slot{});
+        mask = capacity - 1;
+
+        // later arguments replace earlier ones with the same name, which is how the parser has
+        // always handled duplicate names
+        for (size_t i{0}; i < args.size(); ++i) {
+            if (!args[i]->shortName.empty()) insert(args[i]->shortName, i);
+            if (!args[i]->longName.empty()) insert(args[i]->longName, i);
+        }
+    }
+
+    // builds an index of things that have a single name (like subcommands) instead
+    template <typename Item>
+    void buildNames(const std::vector<Item> &items) {
+        size_t capacity{8};
+        while (capacity < items.size() * 2) capacity *= 2;
+        slots.assign(capacity, Slot{});
+        mask = capacity - 1;
+        for (size_t i{0}; i < items.size(); ++i) insert(items[i].name, i);
+    }
+
+    void clear() {
+        slots.clear();
+        mask = 0;
+    }
+
+    static constexpr size_t npos{~size_t{0}};
+
+    // returns the index of the argument with that name (in the order the arguments were given to
+    // build), or npos if there isn't one. this never allocates, so it's safe to call on every token
+    // straight out of argv
+    size_t find(StringView name) const {
+        if (slots.empty()) return npos;
+        const uint32_t hash{hashName(name)};
+        for (size_t i{hash & mask};; i = (i + 1) & mask) {
+            const Slot &slot = slots[i];
+            if (slot.name == nullptr) return npos;
+            if (slot.hash == hash && slot.length == name.length()
+                && std::memcmp(slot.name, name.data(), name.length()) == 0) {
+                return slot.index;
+            }
+        }
+    }
+
+    // 32-bit FNV-1a, which is more than good enough for option names
+    static uint32_t hashName(StringView name) {
+        uint32_t hash{2166136261u};
+        for (const char c : name) {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+private:
+    struct Slot {
+        uint32_t hash{0};
+        uint32_t length{0};
+        const char *name{nullptr}; // points into the argument's own name (nullptr if empty)
+        size_t index{0};
+    };
+    std::vector<Slot> slots;
+    size_t mask{0};
+
+    void insert(StringView name, size_t index) {
+        const uint32_t hash{hashName(name)};
+        for (size_t i{hash & mask};; i = (i + 1) & mask) {
+            Slot &slot = slots[i];
+            if (slot.name == nullptr
+                || (slot.hash == hash && StringView{slot.name, slot.length} == name)) {
+                slot.hash = hash;
+                slot.length = static_cast<uint32_t>(name.length());
+                slot.name = name.data();
+                slot.index = index;
+                return;
+            }
+        }
+    }
+};
+
+// every name in sorted order, which makes the names that start with a given prefix a contiguous
+// range that can be found with a binary search. walking the names in order also visits them the
+// same way a depth-first walk of a trie would, so suggestions reuse the work done for a shared
+// prefix and skip every name under a prefix that's already too far away
+class SortedNames {
+public:
+    struct Entry {
+        StringView name; // points into the argument's own name
+        size_t index;
+    };
+
+    // index is used to work out which argument each name belongs to, so duplicate names end up
+    // with the same argument they do when they're looked up normally
+    template <typename ArgPtr>
+    void build(const std::vector<ArgPtr> &args, const NameIndex &index) {
+        entries.clear();
+        longestName = 0;
+        for (const auto &arg : args) {
+            for (const StringView *name : {&arg->shortName, &arg->longName}) {
+                if (name->empty()) continue;
+                entries.push_back(Entry{*name, index.find(*name)});
+                longestName = std::max(longestName, name->length());
+            }
+        }
+        std::sort(entries.begin(), entries.end(),
+            [](const Entry &a, const Entry &b) { return less(a.name, b.name); });
+        entries.erase(std::unique(entries.begin(), entries.end(),
+                          [](const Entry &a, const Entry &b) { return a.name == b.name; }),
+            entries.end());
+    }
+
+    // the range of entries whose names start with prefix
+    std::pair<const Entry *, const Entry *> withPrefix(StringView prefix) const {
+        const Entry *const first{std::lower_bound(entries.data(), entries.data() + entries.size(),
+            prefix, [](const Entry &entry, StringView name) { return less(entry.name, name); })};
+        return {first, endOfPrefix(first, entries.data() + entries.size(), prefix)};
+    }
+
+    // every name within maxDistance edits (insertions, deletions, or substitutions) of token, with
+    // the closest first
+    std::vector<std::string> suggest(StringView token, size_t maxDistance) const {
+        std::vector<std::pair<size_t, const Entry *>> matches;
+        const size_t columns{token.length() + 1};
+        // row d holds the distances between the first d characters of a name and every prefix of
+        // token, so names that share a prefix share rows
+        const size_t tooFar{maxDistance + 1};
+        std::vector<size_t> rows((longestName + 1) * columns, tooFar);
+        for (size_t j{0}; j < columns; ++j) rows[j] = std::min(j, tooFar);
+
+        const Entry *const end{entries.data() + entries.size()};
+        const Entry *entry{entries.data()};
+        StringView previous;
+        size_t validRows{0}; // how many rows past the first are still right for previous
+        while (entry != end) {
+            const StringView name{entry->name};
+            size_t depth{0};
+            while (depth < validRows && depth < previous.length() && depth < name.length()
+                   && previous[depth] == name[depth]) {
+                ++depth;
+            }
+
+            bool pruned{false};
+            for (; depth < name.length(); ++depth) {
+                const size_t *const above{&rows[depth * columns]};
+                size_t *const row{&rows[(depth + 1) * columns]};
+                // only cells within maxDistance of the diagonal can be within maxDistance, so
+                // everything else is left as (at least) tooFar
+                const size_t i{depth + 1};
+                const size_t first{i > maxDistance ? i - maxDistance : 1};
+                const size_t last{std::min(token.length(), i + maxDistance)};
+                row[0] = std::min(i, tooFar);
+                if (first > 1) row[first - 1] = tooFar;
+                if (last + 1 < columns) row[last + 1] = tooFar;
+                size_t smallest{row[0]};
+                for (size_t j{first}; j <= last; ++j) {
+                    const size_t substitution{above[j - 1] + (token[j - 1] != name[depth])};
+                    row[j] = std::min(std::min(std::min(above[j] + 1, row[j - 1] + 1),
+                        substitution), tooFar);
+                    smallest = std::min(smallest, row[j]);
+                }
+                if (smallest > maxDistance) {
+                    // nothing that starts like this can get any closer, so skip all of it
+                    const StringView prefix{name.data(), depth + 1};
+                    previous = name;
+                    validRows = depth;
+                    entry = endOfPrefix(entry, end, prefix);
+                    pruned = true;
+                    break;
+                }
+            }
+            if (pruned) continue;
+
+            const size_t lengthDifference{name.length() > token.length()
+                                              ? name.length() - token.length()
+                                              : token.length() - name.length()};
+            if (lengthDifference <= maxDistance) {
+                const size_t distance{rows[name.length() * columns + token.length()]};
+                if (distance <= maxDistance) matches.emplace_back(distance, entry);
+            }
+            previous = name;
+            validRows = name.length();
+            ++entry;
+        }
+
+        std::stable_sort(matches.begin(), matches.end(),
+            [](const std::pair<size_t, const Entry *> &a,
+            const std::pair<size_t, const Entry *> &b) { return a.first < b.first; });
+        std::vector<std::string> names;
+        names.reserve(matches.size());
+        for (const auto &match : matches) names.push_back(match.second->name.str());
+        return names;
+    }
+
+    // the order names are sorted in (byte by byte, shorter names first)
+    static bool less(StringView a, StringView b) {
+        const int order{std::memcmp(a.data(), b.data(), std::min(a.length(), b.length()))};
+        return order != 0 ? order < 0 : a.length() < b.length();
+    }
+    static bool startsWith(StringView name, StringView prefix) {
+        return name.length() >= prefix.length()
+               && std::memcmp(name.data(), prefix.data(), prefix.length()) == 0;
+    }
+private:
+    std::vector<Entry> entries;
+    size_t longestName{0};
+
+    // first has to be the first entry that starts with prefix (or the first one after it)
+    static const Entry *endOfPrefix(const Entry *first, const Entry *last, StringView prefix) {
+        return std::partition_point(first, last,
+            [prefix](const Entry &entry) { return startsWith(entry.name, prefix); });
+    }
+};
+
+// monotonic storage for arguments. each argument is constructed in place at the end of the
+// current block, so a parser with thousands of arguments makes a handful of big allocations instead
+// of one per argument. nothing is freed until the arena itself is destroyed
+namespace detail {
+class ArgArena {
+public:
+    explicit ArgArena(size_t blockSize) : blockSize{blockSize} {
+    }
+    ArgArena(const ArgArena &) = delete;
+    ArgArena &operator=(const ArgArena &) = delete;
+    ArgArena(ArgArena &&) = default;
+    ArgArena &operator=(ArgArena &&) = default;
+    ~ArgArena() {
+        // destroyed newest-first, like any other scope
+        for (auto it = objects.rbegin(); it != objects.rend(); ++it) (*it)->~Argument();
+    }
+
+    template <typename ArgType, typename... Args>
+    ArgType *create(Args &&... args) {
+        const size_t blockCount{blocks.size()};
+        const size_t usedBefore{used};
+        void *ptr = allocate(sizeof(ArgType), alignof(ArgType));
+        ArgType *arg;
+        try {
+            arg = new(ptr) ArgType(std::forward<Args>(args)...);
+        } catch (...) {
+            // nothing was constructed, so the space (and any text the constructor copied in
+            // before it threw) can be handed out again
+            used = blocks.size() == blockCount ? usedBefore : 0;
+            throw;
+        }
+        objects.push_back(arg);
+        return arg;
+    }
+    // room for length characters, which are packed in right after whatever came before them
+    char *allocateText(size_t length) {
+        return static_cast<char *>(allocate(length, 1));
+    }
+private:
+    struct BlockDeleter {
+        void operator()(unsigned char *block) const {
+            ::operator delete(block);
+        }
+    };
+    std::vector<std::unique_ptr<unsigned char, BlockDeleter>> blocks;
+    std::vector<Argument *> objects;
+    size_t blockSize;
+    size_t used{0};
+    size_t capacity{0};
+
+    void *allocate(size_t size, size_t alignment) {
+        size_t offset{(used + alignment - 1) & ~(alignment - 1)};
+        if (blocks.empty() || offset + size > capacity) {
+            // anything too big for a normal block gets a block of its own
+            capacity = std::max(blockSize, size);
+            blocks.emplace_back(static_cast<unsigned char *>(::operator new(capacity)));
+            offset = 0;
+        }
+        used = offset + size;
+        return blocks.back().get() + offset;
+    }
+};
+}
+
+inline Argument::Text Argument::copyText(StringView shortName, StringView longName,
+    const Description &description) {
+    const size_t shortLength{!shortName.empty() ? shortName.length() + 1 : 0};
+    const size_t longLength{!longName.empty() ? longName.length() + 2 : 0};
+    const size_t descriptionLength{!description.borrowed ? description.text.length() : 0};
+    const detail::AddContext *const context{detail::addContext()};
+    const StringView positionalName{context != nullptr ? context->positionalName : StringView{}};
+    const size_t length{shortLength + longLength + descriptionLength + positionalName.length()};
+
+    if (context != nullptr && positionalName.empty() && shortName.empty() && longName.empty()) {
+        throw std::invalid_argument("Command-line arguments must have at least one name\n");
+    }
+
+    Text text;
+    if (description.borrowed) text.description = description.text;
+    if (length == 0) return text;
+    char *out;
+    if (context != nullptr && context->arena != nullptr) {
+        out = context->arena->allocateText(length);
+    }
+    else {
+        text.owned.reset(new char[length]);
+        out = text.owned.get();
+    }
+    auto append = [&out](const char *dashes, size_t dashCount, StringView name) {
+        const StringView copy{out, dashCount + name.length()};
+        std::memcpy(out, dashes, dashCount);
+        std::memcpy(out + dashCount, name.data(), name.length());
+        out += copy.length();
+        return copy;
+    };
+    if (shortLength != 0) text.shortName = append("-", 1, shortName);
+    if (longLength != 0) text.longName = append("--", 2, longName);
+    if (descriptionLength != 0) text.description = append("", 0, description.text);
+    if (!positionalName.empty()) text.positionalName = append("", 0, positionalName);
+    return text;
+}
+
+namespace detail {
+// a read-only memory mapping of a whole file. response files are tokenized straight out of the
+// mapping, so their tokens (and any StringView values taken from them) stay valid for as long as
+// the mapping does
+class MappedFile {
+public:
+    MappedFile() = default;
+    // not a file at all, but some text that has to live as long as the mapped files do (like the
+    // chain of paths in a RESPONSE_FILE_CYCLE error)
+    explicit MappedFile(std::string text) : held{std::move(text)}, holdsText{true} {
+    }
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    ~MappedFile() {
+#ifdef _WIN32
+        if (view != nullptr) UnmapViewOfFile(view);
+#else
+        if (view != nullptr) munmap(view, size);
+#endif
+    }
+
+    // returns false if the file couldn't be opened or mapped
+    bool open(const std::string &path) {
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+            OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+        BY_HANDLE_FILE_INFORMATION info;
+        bool ok = GetFileInformationByHandle(file, &info) != 0;
+        if (ok) {
+            id = {info.dwVolumeSerialNumber,
+                (static_cast<uint64_t>(info.nFileIndexHigh) << 32) | info.nFileIndexLow};
+            size = static_cast<size_t>(
+                (static_cast<uint64_t>(info.nFileSizeHigh) << 32) | info.nFileSizeLow);
+        }
+        if (ok && size != 0) {
+            HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mapping != nullptr) {
+                view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+                CloseHandle(mapping);
+            }
+            ok = view != nullptr;
+        }
+        CloseHandle(file);
+        return ok;
+#else
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat info{};
+        bool ok = fstat(fd, &info) == 0 && S_ISREG(info.st_mode);
+        if (ok) {
+            id = {static_cast<uint64_t>(info.st_dev), static_cast<uint64_t>(info.st_ino)};
+            size = static_cast<size_t>(info.st_size);
+        }
+        if (ok && size != 0) {
+            void *mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped != MAP_FAILED) {
+                view = mapped;
+                // response files are only ever read front to back, once
+                madvise(view, size, MADV_SEQUENTIAL);
+            }
+            ok = view != nullptr;
+        }
+        ::close(fd);
+        return ok;
+#endif
+    }
+
+    [[nodiscard]] StringView contents() const {
+        if (holdsText) return held;
+        return {static_cast<const char *>(view), view != nullptr ? size : 0};
+    }
+    // uniquely identifies the file (even through different paths), for detecting include cycles
+    [[nodiscard]] std::pair<uint64_t, uint64_t> identity() const {
+        return id;
+    }
+    // whether this is the same file as other, at the same size (so mapping it again is pointless)
+    [[nodiscard]] bool sameFile(const MappedFile &other) const {
+        return !holdsText && !other.holdsText && id == other.id && size == other.size;
+    }
+private:
+    void *view{nullptr};
+    size_t size{0};
+    std::pair<uint64_t, uint64_t> id{0, 0};
+    std::string held;
+    bool holdsText{false};
+};
+
+// keeps file mapped in files and returns its contents. if the same file is already in there, the
+// old mapping is kept instead (a mapping always shows the file as it is now, so they're the same),
+// so parsing the same response file or config file over and over doesn't pile up mappings
+inline StringView keepMapped(std::vector<std::unique_ptr<MappedFile>> &files,
+    std::unique_ptr<MappedFile> file) {
+    for (const auto &kept : files) {
+        if (kept->sameFile(*file)) return kept->contents();
+    }
+    files.push_back(std::move(file));
+    return files.back()->contents();
+}
+
+inline std::string cycleMessage(StringView chain) {
+    return "Response files include each other in a cycle: " + chain.str() + "\n";
+}
+
+// hands out the tokens of a command one at a time. any "@path" token is replaced by the tokens in
+// the file at that path as they're reached, so a response file is never expanded all at once (or
+// copied anywhere), no matter how big it is. a token that starts with @ but doesn't name a file
+// that can be opened is left alone, like gcc does. the command itself can be any range of things
+// that convert to StringView (C strings, std::strings, StringViews, etc.). a response file that
+// includes itself (even through other files) throws, unless errors is given, in which case the
+// error is added to it and the @path token is handed out like any other token
+template <typename Iterator>
+class TokenStream {
+public:
+    TokenStream(Iterator first, Iterator last, bool expandResponseFiles,
+        std::vector<std::unique_ptr<MappedFile>> &mappedFiles,
+        std::vector<ParseError> *errors = nullptr) :
+        current{first}, last{last}, expandResponseFiles{expandResponseFiles},
+        mappedFiles{mappedFiles}, errors{errors} {
+    }
+
+    // expand is false to hand out an @path token as it is, like every token after "--"
+    bool next(StringView &token, bool expand = true) {
+        if (hasPutBack) {
+            token = putBackToken;
+            hasPutBack = false;
+            ++count;
+            return true;
+        }
+        for (;;) {
+            if (!files.empty()) {
+                if (!nextInFile(files.back(), token)) {
+                    files.pop_back();
+                    continue;
+                }
+            }
+            else {
+                if (current == last) return false;
+                token = *current;
+                ++current;
+                if (token.data() == nullptr) continue; // a null pointer in argv
+            }
+
+            if (expand && expandResponseFiles && token.length() > 1 && token[0] == '@'
+                && openResponseFile(StringView{token.data() + 1, token.length() - 1})) {
+                continue;
+            }
+            ++count;
+            return true;
+        }
+    }
+    // makes token the next one handed out again (it has to be the last one that was)
+    void putBack(StringView token) {
+        putBackToken = token;
+        hasPutBack = true;
+        --count;
+    }
+    // where the next token is in the command
+    [[nodiscard]] size_t position() const {
+        return count;
+    }
+    // hands out every token that's left at once, as the piece of the command they're in. that only
+    // works if the command is an array of C strings (like argv) and none of the tokens that are
+    // left are in a response file, so this returns false (and hands out nothing) otherwise
+    bool takeRest(const char *const *&first, size_t &length) {
+        return takeRest(first, length, std::is_convertible<Iterator, const char *const *>{});
+    }
+private:
+    struct OpenFile {
+        const char *pos;
+        const char *end;
+        std::pair<uint64_t, uint64_t> identity;
+        StringView path; // points into the command, or into the file that included this one
+    };
+
+    Iterator current;
+    Iterator last;
+    bool expandResponseFiles;
+    std::vector<std::unique_ptr<MappedFile>> &mappedFiles;
+    std::vector<OpenFile> files; // every response file currently being read, innermost last
+    std::vector<ParseError> *errors;
+    size_t count{0}; // how many tokens have been handed out
+    StringView putBackToken;
+    bool hasPutBack{false};
+
+    bool openResponseFile(StringView path) {
+        std::unique_ptr<MappedFile> file{new MappedFile};
+        if (!file->open(path.str())) return false;
+
+        for (size_t i{0}; i < files.size(); ++i) {
+            if (files[i].identity != file->identity()) continue;
+            // name every file in the cycle, from the first time this one was opened
+            std::string chain;
+            for (size_t j{i}; j < files.size(); ++j) chain += files[j].path.str() + " -> ";
+            chain += path.str();
+            if (errors == nullptr) throw std::invalid_argument(cycleMessage(chain));
+            mappedFiles.emplace_back(new MappedFile{std::move(chain)});
+            ParseError error;
+            error.kind = ParseError::RESPONSE_FILE_CYCLE;
+            error.token = count;
+            error.value = mappedFiles.back()->contents();
+            errors->push_back(error);
+            return false;
+        }
+
+        const std::pair<uint64_t, uint64_t> identity{file->identity()};
+        const StringView contents{keepMapped(mappedFiles, std::move(file))};
+        files.push_back({contents.begin(), contents.end(), identity, path});
+        return true;
+    }
+
+    // tokens are separated by whitespace, and can be wrapped in single or double quotes to include
+    // whitespace in them
+    static bool nextInFile(OpenFile &file, StringView &token) {
+        const char *pos{file.pos};
+        while (pos != file.end && isSpace(*pos)) ++pos;
+        if (pos == file.end) {
+            file.pos = pos;
+            return false;
+        }
+
+        const char *start{pos};
+        if (*pos == '"' || *pos == '\'') {
+            ++start;
+            const void *close = std::memchr(start, *pos, static_cast<size_t>(file.end - start));
+            pos = close != nullptr ? static_cast<const char *>(close) : file.end;
+            token = {start, static_cast<size_t>(pos - start)};
+            file.pos = pos != file.end ? pos + 1 : pos;
+            return true;
+        }
+
+        while (pos != file.end && !isSpace(*pos)) ++pos;
+        token = {start, static_cast<size_t>(pos - start)};
+        file.pos = pos;
+        return true;
+    }
+
+    static bool isSpace(char c) {
+        return c == ' ' || (c >= '\t' && c <= '\r');
+    }
+
+    bool takeRest(const char *const *&, size_t &, std::false_type) {
+        return false;
+    }
+    bool takeRest(const char *const *&first, size_t &length, std::true_type) {
+        if (hasPutBack || !files.empty()) return false;
+        first = current;
+        length = static_cast<size_t>(last - current);
+        count += length;
+        current = last;
+        return true;
+    }
+};
+
+// reads the "key = value" lines of a config file one at a time, straight out of the file's
+// mapping. a [section] line prefixes every key after it with the section's name and a dash, and
+// both are turned into an argument's long name ("--section-key", with dots replaced by dashes) in
+// a buffer that's reused for every line, so nothing is allocated per line. blank lines and lines
+// starting with # or ; are skipped, and values can be quoted (with no escapes) or followed by a
+// comment that starts with whitespace and a #
+class ConfigReader {
+public:
+    ConfigReader(StringView text, const std::string &path) :
+        pos{text.begin()}, end{text.end()}, path{path} {
+        name.reserve(64);
+        name = "--";
+    }
+
+    // returns false once there are no lines left
+    bool next(StringView &key, StringView &value) {
+        while (pos != end) {
+            ++lineNumber;
+            const char *const lineEnd{findByte(pos, end, '\n')};
+            const StringView line{trim(pos, lineEnd)};
+            pos = lineEnd != end ? lineEnd + 1 : end;
+            if (line.empty() || line[0] == '#' || line[0] == ';') continue;
+
+            if (line[0] == '[') {
+                if (line[line.length() - 1] != ']') error("has an unterminated section name");
+                const StringView section{trim(line.begin() + 1, line.end() - 1)};
+                name.resize(2);
+                appendName(section);
+                if (!section.empty()) name += '-';
+                sectionLength = name.length();
+                continue;
+            }
+
+            const char *const equals{findByte(line.begin(), line.end(), '=')};
+            if (equals == line.end()) error("isn't a \"key = value\" pair");
+            const StringView rawKey{trim(line.begin(), equals)};
+            if (rawKey.empty()) error("has no key");
+            name.resize(sectionLength);
+            appendName(rawKey);
+            key = name;
+            value = parseValue(trim(equals + 1, line.end()));
+            return true;
+        }
+        return false;
+    }
+
+    [[nodiscard]] size_t line() const {
+        return lineNumber;
+    }
+    [[noreturn]] void error(const std::string &problem) const {
+        throw std::invalid_argument("Line " + std::to_string(lineNumber) + " of config file "
+                                    + path + " " + problem + "\n");
+    }
+private:
+    const char *pos;
+    const char *end;
+    const std::string &path;
+    size_t lineNumber{0};
+    std::string name; // "--", then the section prefix, then the key
+    size_t sectionLength{2};
+
+    StringView parseValue(StringView value) const {
+        if (!value.empty() && (value[0] == '"' || value[0] == '\'')) {
+            const char *const close{findByte(value.begin() + 1, value.end(), value[0])};
+            if (close == value.end()) error("has an unterminated quote");
+            const StringView rest{trim(close + 1, value.end())};
+            if (!rest.empty() && rest[0] != '#') error("has something after a quoted value");
+            return {value.begin() + 1, static_cast<size_t>(close - value.begin() - 1)};
+        }
+        // a # only starts a comment after whitespace, so values like "abc#1" still work
+        for (const char *c{value.begin()}; c != value.end(); ++c) {
+            if (*c == '#' && c != value.begin() && isSpace(c[-1])) return trim(value.begin(), c);
+        }
+        return value;
+    }
+    void appendName(StringView part) {
+        for (const char c : part) name += c == '.' ? '-' : c;
+    }
+
+    static StringView trim(const char *first, const char *last) {
+        while (first != last && isSpace(*first)) ++first;
+        while (last != first && isSpace(last[-1])) --last;
+        return {first, static_cast<size_t>(last - first)};
+    }
+    static bool isSpace(char c) {
+        return c == ' ' || (c >= '\t' && c <= '\r');
+    }
+};
+}
+
+// splits a command string into tokens the way a POSIX shell would: tokens are separated by
+// spaces, tabs, and newlines, backslashes escape the next character, single quotes keep everything
+// up to the next single quote, and double quotes do the same except that a backslash can still
+// escape $, `, ", \, or a newline. there are no expansions of any kind.
+// this is a range of StringViews, so it can be given straight to parseCmd (or parse) and nothing
+// is ever copied into a std::string. a token that doesn't need unescaping (no backslashes, and at
+// most one quoted part) is a view straight into the command. anything else is unescaped into the
+// buffer, at the same offset the token started at in the command, so the buffer has to be at least
+// as long as the command and has to outlive anything that points into it. if the buffer *is* the
+// command (the second constructor), it's unescaped in place.
+// unterminated quotes and trailing backslashes throw a std::invalid_argument once they're reached
+class ShellTokens {
+public:
+    ShellTokens(StringView command, char *buffer) : command{command}, buffer{buffer} {
+    }
+    ShellTokens(char *command, size_t length) : command{command, length}, buffer{command} {
+    }
+
+    class iterator {
+    public:
+        typedef std::input_iterator_tag iterator_category;
+        typedef StringView value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const StringView *pointer;
+        typedef const StringView &reference;
+
+        iterator() = default;
+        const StringView &operator*() const {
+            return token;
+        }
+        const StringView *operator->() const {
+            return &token;
+        }
+        iterator &operator++() {
+            atEnd = !nextToken();
+            return *this;
+        }
+        // only "is it at the end" matters, since this is an input iterator
+        friend bool operator==(const iterator &lhs, const iterator &rhs) {
+            return lhs.atEnd == rhs.atEnd;
+        }
+        friend bool operator!=(const iterator &lhs, const iterator &rhs) {
+            return !(lhs == rhs);
+        }
+    private:
+        friend class ShellTokens;
+        const char *begin{nullptr};
+        const char *pos{nullptr};
+        const char *end{nullptr};
+        char *buffer{nullptr};
+        StringView token;
+        bool atEnd{true};
+
+        // the token is either a view (out is null) or has been (partly) unescaped into out
+        const char *tokenStart{nullptr};
+        char *out{nullptr};
+        size_t outLength{0};
+        bool anySegments{false};
+
+        void append(const char *first, const char *last) {
+            if (first == last) return;
+            if (!anySegments) {
+                // the first part of a token can always be a view
+                token = {first, static_cast<size_t>(last - first)};
+                anySegments = true;
+                return;
+            }
+            if (out == nullptr) {
+                // tokens are unescaped at the same offset they started at, so this never writes
+                // over anything that hasn't been read yet (even in place)
+                out = buffer + (tokenStart - begin);
+                std::memmove(out, token.data(), token.length());
+                outLength = token.length();
+            }
+            std::memmove(out + outLength, first, static_cast<size_t>(last - first));
+            outLength += static_cast<size_t>(last - first);
+        }
+
+        bool nextToken() {
+            static const char special[]{' ', '\t', '\n', '\\', '\'', '"'};
+            static const char doubleQuoted[]{'"', '\\'};
+
+            while (pos != end && (*pos == ' ' || *pos == '\t' || *pos == '\n')) ++pos;
+            if (pos == end) return false;
+
+            tokenStart = pos;
+            token = {pos, 0};
+            out = nullptr;
+            outLength = 0;
+            anySegments = false;
+            for (;;) {
+                const char *stop{detail::findAnyOf(pos, end, special, sizeof(special))};
+                append(pos, stop);
+                pos = stop;
+                if (pos == end || *pos == ' ' || *pos == '\t' || *pos == '\n') break;
+
+                if (*pos == '\\') {
+                    if (pos + 1 == end) {
+                        throw std::invalid_argument("Command string ends with a backslash\n");
+                    }
+                    // a backslash before a newline removes both of them
+                    if (pos[1] != '\n') append(pos + 1, pos + 2);
+                    pos += 2;
+                }
+                else if (*pos == '\'') {
+                    const char *close{detail::findByte(pos + 1, end, '\'')};
+                    if (close == end) {
+                        throw std::invalid_argument("Command string has an unterminated quote\n");
+                    }
+                    append(pos + 1, close);
+                    pos = close + 1;
+                }
+                else {
+                    for (++pos;;) {
+                        const char *stopQuoted{
+                            detail::findAnyOf(pos, end, doubleQuoted, sizeof(doubleQuoted))};
+                        if (stopQuoted == end) {
+                            throw std::invalid_argument(
+                                "Command string has an unterminated quote\n");
+                        }
+                        append(pos, stopQuoted);
+                        pos = stopQuoted + 1;
+                        if (*stopQuoted == '"') break;
+                        // inside double quotes, backslashes only escape a few characters
+                        if (pos == end) {
+                            throw std::invalid_argument(
+                                "Command string has an unterminated quote\n");
+                        }
+                        const char escaped{*pos};
+                        if (escaped == '\n') { ++pos; }
+                        else if (escaped == '$' || escaped == '`' || escaped == '"'
+                                 || escaped == '\\') {
+                            append(pos, pos + 1);
+                            ++pos;
+                        }
+                        else { append(stopQuoted, stopQuoted + 1); }
+                    }
+                }
+            }
+
+            if (out != nullptr) token = {out, outLength};
+            return true;
+        }
+    };
+
+    [[nodiscard]] iterator begin() const {
+        iterator it;
+        it.begin = command.begin();
+        it.pos = command.begin();
+        it.end = command.end();
+        it.buffer = buffer;
+        ++it;
+        return it;
+    }
+    [[nodiscard]] iterator end() const {
+        return {};
+    }
+private:
+    StringView command;
+    char *buffer;
+};
+
+// the shells CompletionIndex::script can write completion scripts for
+enum Shell {
+    BASH_SHELL,
+    ZSH_SHELL,
+    FISH_SHELL
+};
+
+// a compact, read-only index of everything a shell might want to complete: the name of every
+// visible argument and subcommand, whether each argument takes a value, and the choices of every
+// ChoiceArg. ArgParser::completionIndex() writes one, which can be saved in a file or embedded in
+// the program, and loaded again without adding a single argument. the index is read in place
+// (names are found with a binary search, and nothing is copied), so answering a completion takes
+// microseconds no matter how many arguments there are
+class CompletionIndex {
+public:
+    CompletionIndex() = default;
+    // data has to outlive the index. it's checked here, so this throws if data isn't an index
+    // written by this version of cmd-args (or is from a machine with a different byte order)
+    explicit CompletionIndex(StringView data) {
+        attach(data);
+    }
+
+    // maps the file at path and reads the index from it in place. returns false if the file
+    // couldn't be opened, and throws if it isn't an index
+    bool open(const std::string &path) {
+        std::unique_ptr<detail::MappedFile> file{new detail::MappedFile};
+        if (!file->open(path)) return false;
+        attach(file->contents());
+        mapped = std::move(file);
+        return true;
+    }
+
+    // calls output(prefix, completion) for every completion of current, given the token before it
+    // (which is empty for the first token):
+    // - after an argument with choices, the completions are the choices that start with current
+    // - after any other argument that takes a value, there aren't any (so the shell can fall back
+    //   to completing file names)
+    // - otherwise, they're every argument and subcommand name that starts with current
+    // --name=value is completed like a name followed by a value, and prefix is the "--name=" part
+    // (it's empty otherwise), since some shells want it back and some don't. the subcommands'
+    // arguments aren't in the index, so after a subcommand's name, only names from the top level
+    // are completed
+    template <typename Output>
+    void complete(StringView previous, StringView current, Output output) const {
+        if (current.length() > 2 && current[0] == '-' && current[1] == '-') {
+            const char *const equals{detail::findByte(current.begin(), current.end(), '=')};
+            if (equals != current.end()) {
+                const StringView name{current.data(),
+                    static_cast<size_t>(equals - current.begin())};
+                const StringView prefix{current.data(), name.length() + 1};
+                const StringView value{equals + 1, current.length() - prefix.length()};
+                const size_t entry{find(name)};
+                if (entry != npos) completeChoices(entry, prefix, value, output);
+                return;
+            }
+        }
+        if (!previous.empty()) {
+            const size_t entry{find(previous)};
+            if (entry != npos && (word(entryWord(entry, FLAGS)) & TAKES_VALUE) != 0) {
+                completeChoices(entry, StringView{}, current, output);
+                return;
+            }
+        }
+        for (size_t entry{lowerBound(current)}; entry < entryCount; ++entry) {
+            const StringView name{entryName(entry)};
+            if (!SortedNames::startsWith(name, current)) break;
+            output(StringView{}, name);
+        }
+    }
+    // the same, but returns the completions (with their prefixes)
+    [[nodiscard]] std::vector<std::string> complete(StringView previous,
+        StringView current) const {
+        std::vector<std::string> completions;
+        complete(previous, current, [&completions](StringView prefix, StringView completion) {
+            completions.push_back(prefix.str() + completion.str());
+        });
+        return completions;
+    }
+
+    // if argv is a completion request (program --complete previous current, which is what the
+    // scripts from script() run), writes every completion to out on a line of its own and returns
+    // true. call this at the very start of main, before adding any arguments
+    bool answer(int argc, const char **argv, std::FILE *out = stdout) const {
+        if (argc < 2 || StringView{argv[1]} != "--complete") return false;
+        const StringView previous{argc > 2 ? argv[2] : ""};
+        const StringView current{argc > 3 ? argv[3] : ""};
+        complete(previous, current, [out](StringView prefix, StringView completion) {
+            std::fwrite(prefix.data(), 1, prefix.length(), out);
+            std::fwrite(completion.data(), 1, completion.length(), out);
+            std::fputc('\n', out);
+        });
+        return true;
+    }
+
+    // a completion script for program (which should be the name it's run by, like "git") that
+    // asks the program itself for completions, so it works with any index the program answers from
+    static std::string script(Shell shell, const std::string &program) {
+        std::string function{"_cmd_args_"};
+        for (const char c : program) {
+            function += std::isalnum(static_cast<unsigned char>(c)) != 0 ? c : '_';
+        }
+        switch (shell) {
+        case BASH_SHELL:
+            return "# bash completion for " + program + ", generated by cmd-args\n"
+                   + function + "() {\n"
+                   "    local cur=\"${COMP_WORDS[COMP_CWORD]}\" prev=\"\"\n"
+                   "    (( COMP_CWORD > 1 )) && prev=\"${COMP_WORDS[COMP_CWORD-1]}\"\n"
+                   "    # bash splits --name=value into three words\n"
+                   "    if [[ $cur == \"=\" ]]; then\n"
+                   "        cur=\"\"\n"
+                   "    elif [[ $prev == \"=\" ]]; then\n"
+                   "        prev=\"${COMP_WORDS[COMP_CWORD-2]}\"\n"
+                   "    fi\n"
+                   "    local IFS=$'\\n'\n"
+                   "    COMPREPLY=($(\"" + program
+                   + "\" --complete \"$prev\" \"$cur\" 2>/dev/null))\n"
+                   "}\n"
+                   "complete -o default -F " + function + " " + program + "\n";
+        case ZSH_SHELL:
+            return "#compdef " + program + "\n"
+                   "# zsh completion for " + program + ", generated by cmd-args\n"
+                   + function + "() {\n"
+                   "    local -a completions\n"
+                   "    completions=(\"${(@f)$(\"" + program
+                   + "\" --complete \"${words[CURRENT-1]}\" \"${words[CURRENT]}\" "
+                     "2>/dev/null)}\")\n"
+                   "    if [[ -n ${completions[1]} ]]; then\n"
+                   "        compadd -Q -- \"${completions[@]}\"\n"
+                   "    else\n"
+                   "        _files\n"
+                   "    fi\n"
+                   "}\n"
+                   "if [[ $zsh_eval_context[-1] == loadautofunc ]]; then\n"
+                   "    " + function + " \"$@\"\n"
+                   "else\n"
+                   "    compdef " + function + " " + program + "\n"
+                   "fi\n";
+        default:
+            return "# fish completion for " + program + ", generated by cmd-args\n"
+                   "function " + function + "\n"
+                   "    set -l tokens (commandline -opc)\n"
+                   "    set -l previous \"\"\n"
+                   "    if test (count $tokens) -gt 1\n"
+                   "        set previous $tokens[-1]\n"
+                   "    end\n"
+                   "    \"" + program
+                   + "\" --complete \"$previous\" (commandline -ct) 2>/dev/null\n"
+                   "end\n"
+                   "complete -c " + program + " -a '(" + function + ")'\n";
+        }
+    }
+private:
+    friend class ArgParser;
+    // the index is a header, then an entry for every name (sorted), then every choice, then the
+    // bytes of every string. everything but the strings is a 32-bit word in the machine's byte
+    // order, and strings are (offset, length) pairs into the string bytes
+    enum : uint32_t {
+        MAGIC = 0x49434143, // "CACI" in little-endian order
+        VERSION = 1
+    };
+    enum : size_t {
+        HEADER_WORDS = 5, // magic, version, entry count, choice count, string bytes
+        // name offset, name length, flags, first choice, choice count
+        NAME_OFFSET = 0,
+        NAME_LENGTH,
+        FLAGS,
+        FIRST_CHOICE,
+        CHOICE_COUNT,
+        ENTRY_WORDS,
+        CHOICE_WORDS = 2 // offset, length
+    };
+    enum : uint32_t {
+        TAKES_VALUE = 1,
+        SUBCOMMAND = 2
+    };
+    static constexpr size_t npos{~size_t{0}};
+
+    StringView data;
+    size_t entryCount{0};
+    size_t choiceCount{0};
+    const char *strings{nullptr};
+    std::unique_ptr<detail::MappedFile> mapped;
+
+    // what ArgParser::completionIndex() writes an entry for
+    struct Name {
+        StringView name;
+        uint32_t flags;
+        const std::vector<std::string> *choices;
+    };
+
+    static std::string write(std::vector<Name> &names) {
+        std::stable_sort(names.begin(), names.end(),
+            [](const Name &a, const Name &b) { return SortedNames::less(a.name, b.name); });
+        names.erase(std::unique(names.begin(), names.end(),
+                        [](const Name &a, const Name &b) { return a.name == b.name; }),
+            names.end());
+
+        std::vector<uint32_t> words{MAGIC, VERSION, static_cast<uint32_t>(names.size()), 0, 0};
+        std::vector<uint32_t> choices;
+        std::string strings;
+        auto addString = [&strings](StringView str, std::vector<uint32_t> &to) {
+            to.push_back(static_cast<uint32_t>(strings.size()));
+            to.push_back(static_cast<uint32_t>(str.length()));
+            strings.append(str.data(), str.length());
+        };
+        for (const Name &name : names) {
+            addString(name.name, words);
+            words.push_back(name.flags);
+            words.push_back(static_cast<uint32_t>(choices.size() / CHOICE_WORDS));
+            words.push_back(name.choices != nullptr ? static_cast<uint32_t>(name.choices->size())
+                                                    : 0);
+            if (name.choices != nullptr) {
+                for (const std::string &choice : *name.choices) addString(choice, choices);
+            }
+        }
+        words[3] = static_cast<uint32_t>(choices.size() / CHOICE_WORDS);
+        words[4] = static_cast<uint32_t>(strings.size());
+        words.insert(words.end(), choices.begin(), choices.end());
+
+        std::string index(words.size() * sizeof(uint32_t), '\0');
+        std::memcpy(&index[0], words.data(), index.size());
+        return index + strings;
+    }
+
+    [[noreturn]] static void invalid() {
+        throw std::invalid_argument("That isn't a completion index from this version of "
+                                    "cmd-args\n");
+    }
+    void attach(StringView index) {
+        data = index;
+        entryCount = choiceCount = 0;
+        if (data.length() < HEADER_WORDS * sizeof(uint32_t) || word(0) != MAGIC
+            || word(1) != VERSION) {
+            invalid();
+        }
+        const uint64_t entries{word(2)}, choices{word(3)}, stringBytes{word(4)};
+        const uint64_t words{HEADER_WORDS + entries * ENTRY_WORDS + choices * CHOICE_WORDS};
+        if (words * sizeof(uint32_t) + stringBytes != data.length()) invalid();
+        strings = data.data() + words * sizeof(uint32_t);
+
+        // everything is checked once here, so lookups never have to
+        auto inStrings = [stringBytes](uint64_t offset, uint64_t length) {
+            return offset + length <= stringBytes;
+        };
+        const size_t choicesStart{HEADER_WORDS + static_cast<size_t>(entries) * ENTRY_WORDS};
+        for (size_t i{0}; i < choices; ++i) {
+            const size_t at{choicesStart + i * CHOICE_WORDS};
+            if (!inStrings(word(at), word(at + 1))) invalid();
+        }
+        for (size_t i{0}; i < entries; ++i) {
+            const size_t at{HEADER_WORDS + i * ENTRY_WORDS};
+            if (!inStrings(word(at + NAME_OFFSET), word(at + NAME_LENGTH))
+                || uint64_t{word(at + FIRST_CHOICE)} + word(at + CHOICE_COUNT) > choices) {
+                invalid();
+            }
+        }
+        entryCount = static_cast<size_t>(entries);
+        choiceCount = static_cast<size_t>(choices);
+    }
+
+    // the index might not be aligned (if it's embedded in a char array, for example)
+    [[nodiscard]] uint32_t word(size_t i) const {
+        uint32_t value;
+        std::memcpy(&value, data.data() + i * sizeof(uint32_t), sizeof(value));
+        return value;
+    }
+    [[nodiscard]] static size_t entryWord(size_t entry, size_t field) {
+        return HEADER_WORDS + entry * ENTRY_WORDS + field;
+    }
+    [[nodiscard]] StringView entryName(size_t entry) const {
+        return {strings + word(entryWord(entry, NAME_OFFSET)), word(entryWord(entry, NAME_LENGTH))};
+    }
+    [[nodiscard]] StringView choiceName(size_t choice) const {
+        const size_t at{HEADER_WORDS + entryCount * ENTRY_WORDS + choice * CHOICE_WORDS};
+        return {strings + word(at), word(at + 1)};
+    }
+
+    // the first entry whose name isn't less than name
+    [[nodiscard]] size_t lowerBound(StringView name) const {
+        size_t first{0}, count{entryCount};
+        while (count > 0) {
+            const size_t half{count / 2};
+            if (SortedNames::less(entryName(first + half), name)) {
+                first += half + 1;
+                count -= half + 1;
+            }
+            else count = half;
+        }
+        return first;
+    }
+    [[nodiscard]] size_t find(StringView name) const {
+        const size_t entry{lowerBound(name)};
+        return entry < entryCount && entryName(entry) == name ? entry : npos;
+    }
+
+    template <typename Output>
+    void completeChoices(size_t entry, StringView prefix, StringView current,
+        Output &output) const {
+        const size_t first{word(entryWord(entry, FIRST_CHOICE))};
+        const size_t last{first + word(entryWord(entry, CHOICE_COUNT))};
+        for (size_t choice{first}; choice < last; ++choice) {
+            const StringView name{choiceName(choice)};
+            if (SortedNames::startsWith(name, current)) output(prefix, name);
+        }
+    }
+};
+
+// how an ArgParser stores its arguments:
+// - SHARED_STORAGE gives each argument its own shared_ptr, which add() returns. the arguments live
+//   as long as any of those pointers do, even after the parser is destroyed (see ~ArgParser)
+// - ARENA_STORAGE constructs the arguments back-to-back in memory owned by the parser (along with
+//   their names and descriptions), and add() returns a non-owning shared_ptr (with no control
+//   block or reference count) to each one, so they're only valid for as long as the parser is
+// the underlying type is fixed so that cmd-args-fwd.hpp can declare it
+enum Storage : int {
+    SHARED_STORAGE,
+    ARENA_STORAGE
+};
+
+// which arguments a constraint counts (see ArgParser::require):
+// - COUNT_SET counts the arguments that were set in the command
+// - COUNT_DEFINED also counts the ones that were given a value some other way: by an environment
+//   variable, or (for arguments without a default) by a config file read before the command, or
+//   by naming an ImplicitArg without a value. a default value doesn't count
+enum ConstraintCount : int {
+    COUNT_SET,
+    COUNT_DEFINED
+};
+
+#if CMD_ARGS_STATS
+// what's happened in every parse since the stats were last reset. misses are tokens that aren't
+// the name of any argument, which includes the values given to arguments
+struct ParseStats {
+    struct Conversion {
+        const Argument *argument;
+        size_t count; // how many times the argument was parsed
+        uint64_t nanoseconds; // how long that took in total
+    };
+
+    size_t parses{0};
+    size_t tokens{0};
+    size_t hits{0};
+    size_t misses{0};
+    uint64_t nanoseconds{0}; // the total wall time of every parse
+    std::vector<Conversion> conversions; // one for each argument, in the order they were added
+};
+
+// override any of these to hear about parses as they happen (for tracing, for example). hooks used
+// with ArgParser::parse() can be called from several threads at once
+class ParseHooks {
+public:
+    virtual ~ParseHooks() = default;
+    virtual void parseStarted() {
+    }
+    // an argument was named in the command, and value (the token after it) took nanoseconds to
+    // parse
+    virtual void argumentParsed(const Argument &, StringView /* value */,
+        uint64_t /* nanoseconds */) {
+    }
+    virtual void unknownToken(StringView) {
+    }
+    // stats holds everything up to and including this parse
+    virtual void parseFinished(const ParseStats & /* stats */, uint64_t /* nanoseconds */) {
+    }
+};
+#endif
+
+namespace detail {
+#if CMD_ARGS_STATS
+// records a single parse into a ParseStats, and passes it along to the hooks (if there are any)
+class ParseRecorder {
+public:
+    ParseRecorder(ParseStats &stats, ParseHooks *hooks, const std::vector<Argument *> &arguments) :
+        stats{stats}, hooks{hooks}, start{Clock::now()} {
+        for (size_t i{stats.conversions.size()}; i < arguments.size(); ++i) {
+            stats.conversions.push_back(ParseStats::Conversion{arguments[i], 0, 0});
+        }
+        ++stats.parses;
+        if (hooks != nullptr) hooks->parseStarted();
+    }
+
+    void token() {
+        ++stats.tokens;
+    }
+    void miss(StringView token) {
+        ++stats.misses;
+        if (hooks != nullptr) hooks->unknownToken(token);
+    }
+    template <typename Parse>
+    void hit(size_t i, StringView value, Parse parse) {
+        ++stats.hits;
+        const Clock::time_point parseStart{Clock::now()};
+        parse();
+        const uint64_t nanoseconds{elapsed(parseStart)};
+        ParseStats::Conversion &conversion = stats.conversions[i];
+        ++conversion.count;
+        conversion.nanoseconds += nanoseconds;
+        if (hooks != nullptr) hooks->argumentParsed(*conversion.argument, value, nanoseconds);
+    }
+    void finish() {
+        const uint64_t nanoseconds{elapsed(start)};
+        stats.nanoseconds += nanoseconds;
+        if (hooks != nullptr) hooks->parseFinished(stats, nanoseconds);
+    }
+private:
+    typedef std::chrono::steady_clock Clock;
+    ParseStats &stats;
+    ParseHooks *hooks;
+    Clock::time_point start;
+
+    static uint64_t elapsed(Clock::time_point since) {
+        return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - since).count());
+    }
+};
+#else
+// does nothing, so every call to it disappears
+class ParseRecorder {
+public:
+    void token() {
+    }
+    void miss(StringView) {
+    }
+    template <typename Parse>
+    void hit(size_t, StringView, Parse parse) {
+        parse();
+    }
+    void finish() {
+    }
+};
+#endif
+}
+
+// a read-only list of some of the tokens in a command (see ArgParser::rest). it either points
+// straight into the command, when the tokens are one piece of an array of C strings like argv
+// (in which case strings() gives that piece, and nothing was copied at all), or at views of the
+// tokens, which the parser keeps. either way the command has to outlive it, and it's only valid
+// until the parser (or result) it came from is reset or parses something else
+class TokenSpan {
+public:
+    class iterator {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef StringView value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const StringView *pointer;
+        typedef StringView reference;
+
+        StringView operator*() const {
+            return strings != nullptr ? StringView{strings[i]} : views[i];
+        }
+        iterator &operator++() {
+            ++i;
+            return *this;
+        }
+        iterator operator++(int) {
+            iterator old{*this};
+            ++i;
+            return old;
+        }
+        friend bool operator==(const iterator &lhs, const iterator &rhs) {
+            return lhs.i == rhs.i;
+        }
+        friend bool operator!=(const iterator &lhs, const iterator &rhs) {
+            return lhs.i != rhs.i;
+        }
+    private:
+        friend class TokenSpan;
+        const char *const *strings;
+        const StringView *views;
+        size_t i;
+        iterator(const char *const *strings, const StringView *views, size_t i) :
+            strings{strings}, views{views}, i{i} {
+        }
+    };
+
+    TokenSpan() = default;
+    TokenSpan(const char *const *strings, size_t count) : strings_{strings}, count{count} {
+    }
+    TokenSpan(const StringView *views, size_t count) : views{views}, count{count} {
+    }
+
+    [[nodiscard]] size_t size() const {
+        return count;
+    }
+    [[nodiscard]] bool empty() const {
+        return count == 0;
+    }
+    // a token from a C string is measured every time it's looked at, which is still cheaper than
+    // measuring every token up front when most of them are only passed along
+    StringView operator[](size_t i) const {
+        return strings_ != nullptr ? StringView{strings_[i]} : views[i];
+    }
+    [[nodiscard]] iterator begin() const {
+        return iterator{strings_, views, 0};
+    }
+    [[nodiscard]] iterator end() const {
+        return iterator{strings_, views, count};
+    }
+    // the piece of the command the tokens are, or nullptr if they had to be gathered up as views
+    [[nodiscard]] const char *const *strings() const {
+        return strings_;
+    }
+private:
+    const char *const *strings_{nullptr};
+    const StringView *views{nullptr};
+    size_t count{0};
+};
+
+namespace detail {
+// where parseTokens puts the tokens that don't go to any argument. the tokens after "--" are
+// taken all at once, and kept as the piece of the command they're in if nothing else was given
+// to rest (and the command is argv-like), so a command made of a handful of options and then
+// 200,000 paths doesn't look at the paths at all
+class RestTokens {
+public:
+    void add(StringView token) {
+        if (strings != nullptr) spill();
+        views.push_back(token);
+    }
+    // everything left in the stream
+    template <typename Stream>
+    void take(Stream &tokens) {
+        const char *const *first{nullptr};
+        size_t length{0};
+        if (tokens.takeRest(first, length)) {
+            if (strings == nullptr && views.empty()) {
+                strings = first;
+                count = length;
+                return;
+            }
+            if (strings != nullptr) spill();
+            views.reserve(views.size() + length);
+            for (size_t i{0}; i < length; ++i) {
+                if (first[i] != nullptr) views.emplace_back(first[i]);
+            }
+            return;
+        }
+        if (strings != nullptr) spill();
+        StringView token;
+        while (tokens.next(token, false)) views.push_back(token);
+    }
+    [[nodiscard]] TokenSpan span() const {
+        if (strings != nullptr) return TokenSpan{strings, count};
+        return TokenSpan{views.data(), views.size()};
+    }
+    void clear() {
+        views.clear();
+        strings = nullptr;
+        count = 0;
+    }
+private:
+    std::vector<StringView> views;
+    const char *const *strings{nullptr}; // used instead of views when the tokens are in one piece
+    size_t count{0};
+
+    // for when more tokens show up after some were kept as a piece of the command (which only
+    // happens if a parser parses several commands without being reset)
+    void spill() {
+        for (size_t i{0}; i < count; ++i) {
+            if (strings[i] != nullptr) views.emplace_back(strings[i]);
+        }
+        strings = nullptr;
+        count = 0;
+    }
+};
+}
+
+class ArgParser {
+public:
+    explicit ArgParser(Storage storage = SHARED_STORAGE, size_t arenaBlockSize = 16 * 1024) :
+        storage{storage}, arena{arenaBlockSize} {
+    }
+    // an argument can only belong to one parser, so parsers can't be copied
+    ArgParser(const ArgParser &) = delete;
+    ArgParser &operator=(const ArgParser &) = delete;
+    // every argument points back at its parser, so moving a parser points them all at the new one.
+    // nothing else follows it, though: a ParseResult, ReloadableResult, or ParseError from before
+    // the move still refers to the old parser. a parser that's been moved from can only be
+    // destroyed or assigned to
+    ArgParser(ArgParser &&other) noexcept :
+        storage{other.storage}, owned{std::move(other.owned)}, arena{std::move(other.arena)},
+        arguments{std::move(other.arguments)}, index{std::move(other.index)},
+        frozen{other.frozen}, sortedNames{std::move(other.sortedNames)},
+        abbreviations{other.abbreviations}, kinds{std::move(other.kinds)},
+        parseFunctions{std::move(other.parseFunctions)}, ownStates{std::move(other.ownStates)},
+        snapshotSizes{std::move(other.snapshotSizes)}, setBits{std::move(other.setBits)},
+        definedBits{std::move(other.definedBits)}, defaultBits{std::move(other.defaultBits)},
+        envBits{std::move(other.envBits)}, lazy{other.lazy},
+        pendingBits{std::move(other.pendingBits)}, constraints{std::move(other.constraints)},
+        constraintMasks{std::move(other.constraintMasks)}, ranges{std::move(other.ranges)},
+        rangeConstraints{std::move(other.rangeConstraints)},
+        envPrefix{std::move(other.envPrefix)}, envBindings{std::move(other.envBindings)},
+        expandResponseFiles{other.expandResponseFiles},
+        responseFiles{std::move(other.responseFiles)}, subcommands{std::move(other.subcommands)},
+        subcommandIndex{std::move(other.subcommandIndex)},
+        chosenSubcommand{other.chosenSubcommand}, fingerprint{other.fingerprint},
+        longestSubcommand{other.longestSubcommand}, longestPositional{other.longestPositional},
+        helpCached{other.helpCached}, helpDefaults{std::move(other.helpDefaults)},
+        helpChoices{std::move(other.helpChoices)}, visibleColumns{other.visibleColumns},
+        allColumns{other.allColumns}, stateOffsets{std::move(other.stateOffsets)},
+        stateBytes{other.stateBytes}, visibleArgs{std::move(other.visibleArgs)},
+        hiddenArgs{std::move(other.hiddenArgs)}, positionals{std::move(other.positionals)},
+        restTokens{std::move(other.restTokens)}
+#if CMD_ARGS_STATS
+        , stats_{other.stats_}, hooks{other.hooks}
+#endif
+    {
+        // the old parser's destructor mustn't cut the arguments loose
+        other.arguments.clear();
+        for (Argument *arg : arguments) arg->owner = this;
+    }
+    ArgParser &operator=(ArgParser &&other) noexcept {
+        if (this != &other) {
+            this->~ArgParser();
+            new (this) ArgParser{std::move(other)};
+        }
+        return *this;
+    }
+    // arguments with SHARED_STORAGE can outlive the parser, so they're cut loose from it here. they
+    // keep their values (a value that lazy conversion deferred is still converted when it's read),
+    // and isSet() and isDefined() keep returning what they did
+    ~ArgParser() {
+        for (Argument *arg : arguments) {
+            arg->detachedSet = detail::testBit(setBits.data(), arg->index);
+            arg->detachedDefined = detail::testBit(definedBits.data(), arg->index);
+            arg->owner = nullptr;
+        }
+    }
+
+    template <typename ArgType, typename... Args>
+    std::shared_ptr<ArgType> add(Args &&... args) {
+        static_assert(std::is_base_of<Argument, ArgType>::value,
+            "Command-line arguments must be of type ChoiceArg, FlagArg, ImplicitArg, ListArg, or "
+            "ValueArg\n");
+        return addArg<ArgType>(StringView{}, std::forward<Args>(args)...);
+    }
+    // adds an argument that's given by where it is in the command instead of by name. each token
+    // that isn't a name, the value of the argument before it, or a subcommand goes to the next
+    // positional argument that doesn't have one yet (in the order they were added), and once
+    // they've all been given one, the rest go to rest(). that includes tokens that start with a
+    // dash but aren't names if they look like negative numbers (-5 or -0.5). name is only used in
+    // help and error messages, and args are what comes after the description in ArgType's
+    // constructor (like the default value). flags can't be positional, since there's no token to
+    // set them with
+    template <typename ArgType, typename... Args>
+    std::shared_ptr<ArgType> addPositional(StringView name, Description description,
+        Args &&... args) {
+        static_assert(std::is_base_of<Argument, ArgType>::value
+                          && !std::is_same<FlagArg, ArgType>::value,
+            "Positional arguments must be of type ChoiceArg, ImplicitArg, ListArg, or ValueArg\n");
+        if (name.empty()) throw std::invalid_argument("Positional arguments must have a name\n");
+        return addArg<ArgType>(name, StringView{}, StringView{}, description,
+            std::forward<Args>(args)...);
+    }
+    // the tokens from the commands parsed so far that didn't go to any argument: ones that aren't
+    // names, values, or subcommands, once every positional argument has one (including ones that
+    // start with a dash but don't name any argument), followed by every token after "--" (which
+    // are never looked at, and aren't expanded as response files). if the command was argv-like
+    // and nothing came before "--", this is just the end of it
+    [[nodiscard]] TokenSpan rest() const {
+        return restTokens.span();
+    }
+
+    // builds the name index used by parseCmd, and works out where each argument's state goes in a
+    // ParseResult. parseCmd freezes the parser automatically, but calling this ahead of time moves
+    // the cost out of the parse (and parse() requires it). adding another argument later just
+    // unfreezes the parser, and everything is rebuilt on the next freeze
+    void freeze() {
+        index.build(arguments);
+        sortedNames.build(arguments, index);
+
+        stateOffsets.clear();
+        stateOffsets.reserve(arguments.size());
+        size_t offset{0};
+        for (const Argument *arg : arguments) {
+            const size_t alignment{arg->stateAlignment()};
+            offset = (offset + alignment - 1) & ~(alignment - 1);
+            stateOffsets.push_back(offset);
+            offset += arg->stateSize();
+        }
+        stateBytes = offset;
+
+        std::stable_sort(envBindings.begin(), envBindings.end(),
+            [](const EnvBinding &a, const EnvBinding &b) { return a.name < b.name; });
+        subcommandIndex.buildNames(subcommands);
+        fingerprint = schemaFingerprint();
+
+        frozen = true;
+    }
+    [[nodiscard]] bool isFrozen() const {
+        return frozen;
+    }
+
+    // parses the command, and stores the results in the arguments themselves. any token of the
+    // form @path is replaced by the whitespace-separated tokens in that file (which can contain
+    // more @path tokens, as long as no file ends up including itself)
+    void parseCmd(int argc, const char **argv) {
+        // start after the first item in argv, because it's always the path to the executable
+        parseCmd(argv + (argc > 0 ? 1 : 0), argv + argc);
+    }
+    // these parse any range of tokens that convert to StringView, like a std::vector<StringView>
+    // or an array of std::strings. unlike argv, the range shouldn't start with the program's path
+    template <typename Iterator>
+    void parseCmd(Iterator first, Iterator last) {
+        parseOwn(first, last, nullptr, Thrower{this});
+    }
+    template <typename Tokens>
+    void parseCmd(const Tokens &tokens) {
+        parseCmd(std::begin(tokens), std::end(tokens));
+    }
+    void parseCmd(std::initializer_list<StringView> tokens) {
+        parseCmd(tokens.begin(), tokens.end());
+    }
+
+    // the same as parseCmd, but problems with the command (missing or invalid values, ambiguous
+    // abbreviations, response files that include themselves, and invalid environment variables)
+    // don't throw. each one is added to the returned status, and parsing carries on, so the status
+    // holds every error in the command. an argument with an invalid value is left as it was.
+    // messages are only built if errorMessage is called, and nothing is allocated unless there's
+    // an error
+    ParseStatus tryParseCmd(int argc, const char **argv) {
+        return tryParseCmd(argv + (argc > 0 ? 1 : 0), argv + argc);
+    }
+    template <typename Iterator>
+    ParseStatus tryParseCmd(Iterator first, Iterator last) {
+        ParseStatus status;
+        std::vector<ParseError> &errors = status.errors_;
+        parseOwn(first, last, &errors, [&errors](const ParseError &error) {
+            errors.push_back(error);
+        });
+        return status;
+    }
+    template <typename Tokens>
+    ParseStatus tryParseCmd(const Tokens &tokens) {
+        return tryParseCmd(std::begin(tokens), std::end(tokens));
+    }
+    ParseStatus tryParseCmd(std::initializer_list<StringView> tokens) {
+        return tryParseCmd(tokens.begin(), tokens.end());
+    }
+
+    // the message parseCmd would have thrown for an error
+    [[nodiscard]] std::string errorMessage(const ParseError &error) const {
+        // errors after a subcommand's name belong to the subcommand's parser
+        if (error.parser != nullptr && error.parser != this) {
+            return error.parser->errorMessage(error);
+        }
+        switch (error.kind) {
+        case ParseError::AMBIGUOUS_NAME: {
+            std::string candidates;
+            const auto range = sortedNames.withPrefix(error.value);
+            for (auto candidate = range.first; candidate != range.second; ++candidate) {
+                candidates += (candidate == range.first ? "" : ", ") + candidate->name.str();
+            }
+            return "Command-line argument " + error.value.str() + " is ambiguous (it could be "
+                   + candidates + ")\n";
+        }
+        case ParseError::RESPONSE_FILE_CYCLE: return detail::cycleMessage(error.value);
+        case ParseError::INVALID_ENVIRONMENT_VALUE: {
+            const char *const equals{detail::findByte(error.value.begin(), error.value.end(), '=')};
+            const StringView name{error.value.data(),
+                static_cast<size_t>(equals - error.value.begin())};
+            const StringView value{equals + 1, static_cast<size_t>(error.value.end() - equals - 1)};
+            return "Environment variable " + name.str() + " (for command-line argument "
+                   + arguments[error.argument]->namesForErrors() + ") has an invalid value of \""
+                   + value.str() + "\"\n";
+        }
+        case ParseError::MISSING_REQUIRED:
+            return "Command-line argument " + arguments[error.argument]->namesForErrors()
+                   + " is required\n";
+        case ParseError::MISSING_ONE_OF:
+            return "One of the command-line arguments " + groupNames(constraints[error.constraint])
+                   + " is required\n";
+        case ParseError::MUTUALLY_EXCLUSIVE:
+            return "Only one of the command-line arguments "
+                   + groupNames(constraints[error.constraint]) + " can be given\n";
+        case ParseError::MISSING_DEPENDENCY:
+            return "Command-line argument " + arguments[error.argument]->namesForErrors()
+                   + " requires " + groupNames(constraints[error.constraint]) + "\n";
+        case ParseError::CONFLICTING:
+            return "Command-line argument " + arguments[error.argument]->namesForErrors()
+                   + " can't be given along with " + groupNames(constraints[error.constraint])
+                   + "\n";
+        case ParseError::OUT_OF_RANGE:
+            return "Command-line argument " + arguments[error.argument]->namesForErrors()
+                   + " has to be between "
+                   + ranges[constraints[error.constraint].range]->describe() + "\n";
+        default: return arguments[error.argument]->errorMessage(error);
+        }
+    }
+    // every error's message, in order
+    [[nodiscard]] std::string errorMessages(const ParseStatus &status) const {
+        std::string messages;
+        for (const ParseError &error : status.errors()) messages += errorMessage(error);
+        return messages;
+    }
+
+    // writes a CompletionIndex of the visible arguments and the subcommands (but not the
+    // subcommands' own arguments, so none of their parsers are built). it only changes when the
+    // arguments do, so it can be written once (at build time, or the first time the program runs)
+    // and saved, and completions can then be answered without creating a parser at all
+    [[nodiscard]] std::string completionIndex() {
+        if (!frozen) freeze();
+        std::vector<CompletionIndex::Name> names;
+        for (const Argument *arg : arguments) {
+            if (arg->visibility != VISIBLE) continue;
+            const uint32_t flags{
+                kinds[arg->index] != FLAG_KIND ? uint32_t{CompletionIndex::TAKES_VALUE} : 0u};
+            for (const StringView *name : {&arg->shortName, &arg->longName}) {
+                // a name that a later argument also has belongs to that argument
+                if (name->empty() || index.find(*name) != arg->index) continue;
+                names.push_back(CompletionIndex::Name{*name, flags, arg->choiceList()});
+            }
+        }
+        for (const Subcommand &sub : subcommands) {
+            names.push_back(CompletionIndex::Name{sub.name, CompletionIndex::SUBCOMMAND, nullptr});
+        }
+        return CompletionIndex::write(names);
+    }
+
+    // adds a subcommand (like git's commit or log), whose arguments go in a parser of its own.
+    // registerArgs fills that parser in, and it's only called the first time the parser is needed:
+    // when the subcommand's name shows up in a command, or when subcommandParser is called. so a
+    // program with lots of subcommands only pays for adding the arguments of the one it runs. the
+    // first token that's a subcommand's name (and isn't the value of the argument before it) ends
+    // this parser's part of the command, and the rest is parsed by the subcommand's parser
+    void addSubcommand(std::string name, std::string description,
+        std::function<void(ArgParser &)> registerArgs) {
+        if (name.empty() || name[0] == '-') {
+            throw std::invalid_argument("Subcommand names can't be empty or start with a dash\n");
+        }
+        subcommands.push_back(Subcommand{std::move(name), std::move(description),
+            std::move(registerArgs), nullptr});
+        frozen = false;
+        helpCached = false;
+    }
+    // the name of the subcommand in the last command that was parsed (empty if there wasn't one)
+    [[nodiscard]] StringView subcommand() const {
+        if (chosenSubcommand == NameIndex::npos) return {};
+        return subcommands[chosenSubcommand].name;
+    }
+    // the parser for a subcommand, which is built if it hasn't been already (so this is also how
+    // to get a subcommand's help message)
+    ArgParser &subcommandParser(StringView name) {
+        for (size_t i{0}; i < subcommands.size(); ++i) {
+            if (subcommands[i].name == name) return subcommandParser(i);
+        }
+        throw std::invalid_argument("There's no subcommand named " + name.str() + "\n");
+    }
+
+    // constraints on which arguments a command sets. they're checked in the order they were
+    // added, once parseCmd, tryParseCmd, or parse() has parsed the whole command (and the
+    // environment), and each broken one is an error like any other (one of the constraint kinds
+    // in ParseError). every group is compiled into a mask for each word of the set bitset it
+    // touches, so checking one costs a few word operations however many arguments there are.
+    // values from the environment make an argument defined and not set, so by default only ranges
+    // see them. pass COUNT_DEFINED to have a constraint count them as well (see ConstraintCount)
+    typedef std::vector<std::shared_ptr<const Argument>> Group;
+    // arg has to be set
+    void require(const std::shared_ptr<const Argument> &arg, ConstraintCount count = COUNT_SET) {
+        addConstraint(ParseError::MISSING_REQUIRED, ParseError::npos, Group{arg}, 1, NO_LIMIT,
+            count);
+    }
+    // at least one of the group has to be set
+    void atLeastOne(const Group &group, ConstraintCount count = COUNT_SET) {
+        addConstraint(ParseError::MISSING_ONE_OF, ParseError::npos, group, 1, NO_LIMIT, count);
+    }
+    // no more than one of the group can be set
+    void mutuallyExclusive(const Group &group, ConstraintCount count = COUNT_SET) {
+        addConstraint(ParseError::MUTUALLY_EXCLUSIVE, ParseError::npos, group, 0, 1, count);
+    }
+    // exactly one of the group has to be set (which is both of the above)
+    void exactlyOne(const Group &group, ConstraintCount count = COUNT_SET) {
+        mutuallyExclusive(group, count);
+        atLeastOne(group, count);
+    }
+    // if arg is set, other has to be too (count applies to both of them)
+    void dependsOn(const std::shared_ptr<const Argument> &arg,
+        const std::shared_ptr<const Argument> &other, ConstraintCount count = COUNT_SET) {
+        addConstraint(ParseError::MISSING_DEPENDENCY, indexIn(arg), Group{other}, 1, NO_LIMIT,
+            count);
+    }
+    // arg and other can't both be set
+    void conflicts(const std::shared_ptr<const Argument> &arg,
+        const std::shared_ptr<const Argument> &other, ConstraintCount count = COUNT_SET) {
+        addConstraint(ParseError::CONFLICTING, indexIn(arg), Group{other}, 0, 0, count);
+    }
+    // a number argument's value has to be between min and max (inclusive) whenever it's
+    // defined, including when it comes from the environment or a config file (which is checked
+    // as it's read, like an invalid value). the default has to be in range too
+    template <typename ArgType>
+    void range(const std::shared_ptr<ArgType> &arg, const typename ArgType::ValueType &min,
+        const typename ArgType::ValueType &max) {
+        typedef typename ArgType::ValueType T;
+        static_assert(std::is_arithmetic<T>::value && !std::is_same<T, bool>::value,
+            "Only arguments that hold numbers can have a range\n");
+        const size_t i{indexIn(arg)};
+        if (max < min) {
+            throw std::invalid_argument("The range for command-line argument "
+                                        + arg->namesForErrors() + " is empty\n");
+        }
+        std::unique_ptr<RangeCheck> check{new TypedRange<T>{min, max}};
+        if (arg->definedByDefault_ && !check->contains(&arg->dv)) {
+            throw std::invalid_argument("The default value of command-line argument "
+                                        + arg->namesForErrors() + " isn't in its range\n");
+        }
+        Constraint constraint{ParseError::OUT_OF_RANGE, i, 0, 0, 0, 0, ranges.size(), COUNT_SET};
+        const std::pair<size_t, size_t> byArgument{i, constraints.size()};
+        rangeConstraints.insert(std::upper_bound(rangeConstraints.begin(), rangeConstraints.end(),
+                                    byArgument),
+            byArgument);
+        ranges.push_back(std::move(check));
+        constraints.push_back(constraint);
+    }
+
+    // puts every argument back to how it was before anything was parsed, so the parser can be
+    // reused for another command. values are copy-assigned from their defaults, so strings and
+    // vectors keep whatever memory they already had
+    void reset() {
+        for (size_t i{0}; i < arguments.size(); ++i) {
+            if (kinds[i] == FLAG_KIND) { *static_cast<bool *>(ownStates[i]) = false; }
+            else arguments[i]->resetState(ownStates[i]);
+        }
+        std::fill(setBits.begin(), setBits.end(), uint64_t{0});
+        std::fill(envBits.begin(), envBits.end(), uint64_t{0});
+        dropAllPending();
+        std::copy(defaultBits.begin(), defaultBits.end(), definedBits.begin());
+        chosenSubcommand = NameIndex::npos;
+        for (Subcommand &sub : subcommands) {
+            if (sub.parser != nullptr) sub.parser->reset();
+        }
+        restTokens.clear();
+        responseFiles.clear(); // nothing can be pointing into them anymore
+    }
+
+    // how many arguments were set by the commands parsed so far, counted straight from a bitset
+    [[nodiscard]] size_t setCount() const {
+        return detail::countBits(setBits.data(), setBits.size());
+    }
+    // calls f with every argument that was set, in the order they were added
+    template <typename Function>
+    void forEachSet(Function f) const {
+        detail::forEachBit(setBits.data(), setBits.size(),
+            [this, &f](size_t i) { f(static_cast<const Argument &>(*arguments[i])); });
+    }
+
+    // writes everything the commands parsed so far have left in the parser (every argument's
+    // value, whether it was set or defined, and the subcommand that was chosen, along with its
+    // parser's state) into a compact binary snapshot. loadSnapshot puts all of it back into a
+    // parser with the same arguments without parsing or converting anything, so a process can
+    // parse its command once and pass the results to the workers it starts. values that haven't
+    // been converted yet (with lazy conversion) are converted first, so this can throw
+    [[nodiscard]] std::string snapshot() const {
+        validateAll();
+        std::string out;
+        writeSnapshot(out);
+        return out;
+    }
+    // replaces the parser's state with a snapshot from a parser with the same arguments (added in
+    // the same order), which throws if it isn't one. numbers and enums are copied straight out of
+    // the snapshot (enums aren't checked), bools have to be 0 or 1, and StringView values point
+    // into it, so the snapshot has to outlive them. it's only ever read, so it can be in read-only
+    // (or shared) memory
+    void loadSnapshot(StringView data) {
+        if (!readSnapshot(data) || !data.empty()) {
+            reset();
+            throw std::invalid_argument("That isn't a snapshot of this parser from this version of "
+                                        "cmd-args\n");
+        }
+    }
+    // maps the file at path read-only and loads the snapshot in it, which stays mapped until the
+    // parser is reset (like a response file). returns false if the file couldn't be opened
+    bool loadSnapshotFile(const std::string &path) {
+        std::unique_ptr<detail::MappedFile> file{new detail::MappedFile};
+        if (!file->open(path)) return false;
+        // loading a snapshot drops every file that was kept (and resets the parser if it throws),
+        // so this one can't already be in there
+        loadSnapshot(file->contents());
+        responseFiles.push_back(std::move(file));
+        return true;
+    }
+
+    // parses the command like parseCmd does, but stores the results in a new ParseResult instead
+    // of the arguments. this never modifies the parser, so once it's frozen any number of threads
+    // can call this at the same time (as long as nothing adds arguments in the meantime)
+    [[nodiscard]] ParseResult parse(int argc, const char **argv) const;
+    template <typename Iterator>
+    [[nodiscard]] ParseResult parse(Iterator first, Iterator last) const;
+    template <typename Tokens>
+    [[nodiscard]] ParseResult parse(const Tokens &tokens) const;
+    [[nodiscard]] ParseResult parse(std::initializer_list<StringView> tokens) const;
+    // resets an existing result and parses into it, which saves allocating a new one
+    template <typename Iterator>
+    void parse(ParseResult &result, Iterator first, Iterator last) const;
+
+    // response files are off by default, since with them any value that starts with @ and names a
+    // file that exists is replaced by what's in the file
+    void enableResponseFiles(bool enable = true) {
+        expandResponseFiles = enable;
+    }
+
+    // with abbreviations, a token that isn't a name but starts with "--" and is the beginning of
+    // exactly one long name (like --verb for --verbose) is treated as that name. a token that's
+    // the beginning of more than one throws a std::invalid_argument. they're off by default
+    void enableAbbreviations(bool enable = true) {
+        abbreviations = enable;
+    }
+    // returns every name within maxDistance edits of token, closest first, for "did you mean"
+    // messages. the parser has to be frozen
+    [[nodiscard]] std::vector<std::string> suggest(StringView token, size_t maxDistance = 2) const {
+        if (!frozen) {
+            throw std::logic_error("ArgParser::suggest() requires the parser to be frozen first\n");
+        }
+        return sortedNames.suggest(token, maxDistance);
+    }
+
+    // with lazy conversion, parseCmd only records the value of each ValueArg or ImplicitArg
+    // (whether it's the next token, attached like --name=value or -j8, or a positional argument),
+    // and it's converted the first time value() is called on the argument (so that's where invalid
+    // values are reported). the tokens have to stay alive until then. it's off by default, and
+    // doesn't affect parse()
+    void enableLazyConversion(bool enable = true) {
+        lazy = enable;
+    }
+    // converts every value that hasn't been converted yet, so invalid values throw here instead of
+    // whenever they're read
+    void validateAll() const {
+        detail::forEachBit(pendingBits.data(), pendingBits.size(),
+            [this](size_t i) { resolveArg(i); });
+    }
+
+    // lets an argument fall back to an environment variable when it isn't set in the command (its
+    // default value is still used if the variable doesn't exist either). the variable's name is
+    // the prefix followed by name, or by the argument's long name (or short name, or positional
+    // name) in upper case with dashes replaced by underscores if name is empty, so --thread-count
+    // with the prefix "MYTOOL_" is bound to MYTOOL_THREAD_COUNT. values from the environment make
+    // an argument defined, not set
+    template <typename ArgType>
+    void bindEnv(const std::shared_ptr<ArgType> &arg, std::string name = "") {
+        if (arg == nullptr || arg->owner != this) {
+            throw std::invalid_argument(
+                "Only arguments added to this parser can be bound to environment variables\n");
+        }
+        if (name.empty()) {
+            const StringView argName{!arg->longName.empty()    ? arg->longName
+                                     : !arg->shortName.empty() ? arg->shortName
+                                                               : arg->positionalName};
+            size_t start{0};
+            while (start < argName.length() && argName[start] == '-') ++start;
+            for (size_t i{start}; i < argName.length(); ++i) {
+                const char c{argName[i]};
+                name += c == '-' ? '_' : static_cast<char>(std::toupper(
+                    static_cast<unsigned char>(c)));
+            }
+        }
+        envBindings.push_back(EnvBinding{std::move(name), arg->index});
+        frozen = false; // the bindings are sorted when the parser is frozen
+    }
+    // sets arguments from a config file of "key = value" lines, where each key is an argument's
+    // long name without the dashes. keys after a [section] line have the section's name and a dash
+    // in front of them, so "port = 80" after [server] sets --server-port. values from a config file
+    // make an argument defined but not set, and they come last: arguments that have been set in
+    // the command, or given a value by an environment variable, are left alone (so it doesn't
+    // matter if this is called before or after parseCmd). keys that don't belong to an argument
+    // are skipped. the file is memory-mapped, and kept mapped until the parser is reset, since
+    // StringView values point into it
+    void parseConfigFile(const std::string &path) {
+        if (!frozen) freeze();
+        readConfigFile(path, responseFiles, [this](size_t i) { return ownStates[i]; },
+            setBits.data(), envBits.data(), definedBits.data());
+    }
+    // the same, but sets the arguments in a result from parse() instead, so the parser itself is
+    // never modified (and it has to be frozen already)
+    void parseConfigFile(ParseResult &result, const std::string &path) const;
+
+    // every variable bound with bindEnv starts with this, and only variables that do are looked
+    // at when parsing. it's empty by default
+    void setEnvPrefix(std::string prefix) {
+        envPrefix = std::move(prefix);
+    }
+
+#if CMD_ARGS_STATS
+    // the stats for every parseCmd since the parser was created (or the stats were reset). each
+    // ParseResult has the stats for its own parse
+    [[nodiscard]] const ParseStats &stats() const {
+        return stats_;
+    }
+    void resetStats() {
+        stats_ = ParseStats{};
+    }
+    // the hooks are called by every parse, including parse(). pass nullptr to stop calling them
+    void setHooks(ParseHooks *parseHooks) {
+        hooks = parseHooks;
+    }
+#endif
+
+    // creates and returns a formatted help message containing every command
+    std::string createHelpMessage(bool showHidden = false) {
+        // the message is measured first, so the string only has to be allocated once
+        size_t length{0};
+        writeHelpMessage(showHidden, [&length](const char *, size_t size) { length += size; });
+        std::string helpMessage;
+        helpMessage.reserve(length);
+        writeHelpMessage(showHidden,
+            [&helpMessage](const char *str, size_t size) { helpMessage.append(str, size); });
+        return helpMessage;
+    }
+    // these write the help message straight to a stream or file, without building it in memory
+    void createHelpMessage(std::ostream &stream, bool showHidden = false) {
+        writeHelpMessage(showHidden, [&stream](const char *str, size_t size) {
+            stream.write(str, static_cast<std::streamsize>(size));
+        });
+    }
+    void createHelpMessage(std::FILE *file, bool showHidden = false) {
+        writeHelpMessage(showHidden,
+            [file](const char *str, size_t size) { std::fwrite(str, 1, size, file); });
+    }
+
+private:
+    Storage storage;
+    // exactly one of these owns the arguments, depending on the storage mode
+    std::vector<std::shared_ptr<Argument>> owned;
+    detail::ArgArena arena;
+
+    // points detail::addContext at a context for as long as it exists
+    class AddScope {
+    public:
+        explicit AddScope(detail::AddContext &context) : previous{detail::addContext()} {
+            detail::addContext() = &context;
+        }
+        AddScope(const AddScope &) = delete;
+        AddScope &operator=(const AddScope &) = delete;
+        ~AddScope() {
+            detail::addContext() = previous;
+        }
+    private:
+        detail::AddContext *previous;
+    };
+    // add() and addPositional() (positionalName is only given by addPositional)
+    template <typename ArgType, typename... Args>
+    std::shared_ptr<ArgType> addArg(StringView positionalName, Args &&... args) {
+        // the argument's constructor checks its names and copies them (into the arena, if it's
+        // going in the arena too) in Argument::copyText, so an argument without a name never gets
+        // as far as being stored
+        detail::AddContext context{storage == ARENA_STORAGE ? &arena : nullptr, positionalName};
+        AddScope scope{context};
+        std::shared_ptr<ArgType> argPtr;
+        if (storage == ARENA_STORAGE) {
+            // aliasing an empty shared_ptr gives a pointer that doesn't own (or count) anything
+            argPtr = std::shared_ptr<ArgType>(std::shared_ptr<ArgType>(),
+                arena.create<ArgType>(std::forward<Args>(args)...));
+        }
+        else {
+            argPtr = std::make_shared<ArgType>(std::forward<Args>(args)...);
+            owned.push_back(argPtr);
+        }
+        Argument *arg = argPtr.get();
+
+        // the name index is rebuilt the next time the parser is frozen
+        const size_t i{arguments.size()};
+        arg->owner = this;
+        arg->index = i;
+        arguments.push_back(arg);
+        kinds.push_back(std::is_same<FlagArg, ArgType>::value ? FLAG_KIND : CALL_KIND);
+        parseFunctions.push_back(&ArgParser::parseWith<ArgType>);
+        ownStates.push_back(arg->ownState());
+        snapshotSizes.push_back(arg->plainSnapshotSize());
+        if (i / 64 == setBits.size()) {
+            setBits.push_back(0);
+            definedBits.push_back(0);
+            defaultBits.push_back(0);
+            envBits.push_back(0);
+            pendingBits.push_back(0);
+        }
+        if (arg->definedByDefault_) {
+            detail::setBit(definedBits.data(), i);
+            detail::setBit(defaultBits.data(), i);
+        }
+        frozen = false;
+        helpCached = false;
+
+        // add the argument to one of the two vectors based on its visibility (invisible arguments
+        // aren't added to either). positional arguments get a vector of their own, which is also
+        // the order they're filled in
+        if (!positionalName.empty()) { positionals.push_back(i); }
+        else if (arg->visibility == VISIBLE) { visibleArgs.push_back(arg); }
+        else if (arg->visibility == HIDDEN) hiddenArgs.push_back(arg);
+
+        return argPtr;
+    }
+
+    // every argument, in the order it was added. the index has a slot for each of an argument's
+    // names, so they're looked up through that rather than searched directly
+    std::vector<Argument *> arguments;
+    NameIndex index;
+    bool frozen{false};
+
+    // used for abbreviations and suggestions
+    SortedNames sortedNames;
+    bool abbreviations{false};
+
+    // an ambiguous abbreviation is rejected, and then treated like any other unknown token
+    template <typename Reject>
+    size_t findAbbreviation(StringView token, size_t position, Reject &reject) const {
+        if (token.length() <= 2 || token[0] != '-' || token[1] != '-') return NameIndex::npos;
+        const auto range = sortedNames.withPrefix(token);
+        if (range.first == range.second) return NameIndex::npos;
+        for (auto entry = range.first + 1; entry != range.second; ++entry) {
+            if (entry->index != range.first->index) {
+                ParseError error;
+                error.kind = ParseError::AMBIGUOUS_NAME;
+                error.token = position;
+                error.value = token;
+                error.parser = this;
+                reject(error);
+                return NameIndex::npos;
+            }
+        }
+        return range.first->index;
+    }
+
+    // everything parsing touches is kept in flat arrays indexed like arguments, so a parse never
+    // has to go through the (much bigger) arguments themselves unless it's converting a value.
+    // each argument's parse function calls its type's parseValue directly, and flags don't need
+    // one at all
+    enum Kind : unsigned char {
+        CALL_KIND, // goes through parseFunctions
+        FLAG_KIND
+    };
+    typedef unsigned (*ParseFunction)(const Argument &, void *, bool, StringView, bool,
+        ParseError &);
+    std::vector<unsigned char> kinds;
+    std::vector<ParseFunction> parseFunctions;
+    std::vector<void *> ownStates; // the states the arguments keep for themselves
+    std::vector<size_t> snapshotSizes; // each argument's plainSnapshotSize()
+    friend class Argument;
+    std::vector<uint64_t> setBits; // what isSet() reads
+    std::vector<uint64_t> definedBits; // what isDefined() reads
+    std::vector<uint64_t> defaultBits; // which arguments are defined by default
+    std::vector<uint64_t> envBits; // which arguments the environment gave a value (see applyEnv)
+
+    template <typename ArgType>
+    static unsigned parseWith(const Argument &arg, void *state, bool wasSet, StringView value,
+        bool attached, ParseError &error) {
+        return static_cast<const ArgType &>(arg).ArgType::parseValue(state, wasSet, value, attached,
+            error);
+    }
+    // which arguments have a value that lazy conversion hasn't converted yet (the values
+    // themselves are kept by the arguments, so value() never has to look at the parser unless
+    // there's one). resolving them changes the bits from const methods, which is why they're
+    // mutable
+    bool lazy{false};
+    mutable std::vector<uint64_t> pendingBits;
+
+    bool deferArg(size_t i, StringView value, bool attached) {
+        Argument &arg = *arguments[i];
+        const unsigned marks{arg.deferValue(value, attached)};
+        if (marks == 0) return false;
+        arg.pendingValue = value;
+        arg.pending = true;
+        detail::setBit(pendingBits.data(), i);
+        if (marks & Argument::MARK_SET) detail::setBit(setBits.data(), i);
+        if (marks & Argument::MARK_DEFINED) detail::setBit(definedBits.data(), i);
+        return true;
+    }
+    // forgets a deferred value without converting it
+    void dropPending(size_t i) {
+        detail::clearBit(pendingBits.data(), i);
+        arguments[i]->pending = false;
+    }
+    void dropAllPending() {
+        detail::forEachBit(pendingBits.data(), pendingBits.size(),
+            [this](size_t i) { arguments[i]->pending = false; });
+        std::fill(pendingBits.begin(), pendingBits.end(), uint64_t{0});
+    }
+    void resolveArg(size_t i) const {
+        ParseError error;
+        if (!convertPending(i, error)) {
+            throw std::invalid_argument(arguments[i]->errorMessage(error));
+        }
+    }
+    // the value stays pending if it's invalid, so it throws every time it's read
+    bool convertPending(size_t i, ParseError &error) const {
+        const Argument &arg = *arguments[i];
+        if (parseFunctions[i](arg, ownStates[i], false, arg.pendingValue, true, error) == 0) {
+            return false;
+        }
+        detail::clearBit(pendingBits.data(), i);
+        arg.pending = false;
+        return true;
+    }
+
+    // constraints, in the order they were added. a group constraint is broken when the number of
+    // its arguments that are set isn't between least and most, and it's only checked when its
+    // trigger is set (if it has one). ranges use the trigger as the argument that's checked
+    enum : uint32_t {
+        NO_LIMIT = ~uint32_t{0}
+    };
+    struct Constraint {
+        ParseError::Kind kind;
+        size_t trigger;
+        uint32_t firstMask; // where the group's masks start in constraintMasks
+        uint32_t maskCount;
+        uint32_t least;
+        uint32_t most;
+        size_t range; // where the bounds are in ranges (for OUT_OF_RANGE)
+        ConstraintCount count; // unused for ranges, which check every defined value
+    };
+    // the bits of a group that are in one word of the set bitset
+    struct WordMask {
+        size_t word;
+        uint64_t bits;
+    };
+    class RangeCheck {
+    public:
+        virtual ~RangeCheck() = default;
+        [[nodiscard]] virtual bool contains(const void *state) const = 0;
+        // for error messages, so they aren't the only thing that has to know the type
+        [[nodiscard]] virtual std::string describe() const = 0;
+    };
+    template <typename T>
+    class TypedRange : public RangeCheck {
+    public:
+        TypedRange(const T &min, const T &max) : min{min}, max{max} {
+        }
+        [[nodiscard]] bool contains(const void *state) const override {
+            const T &value = *static_cast<const T *>(state);
+            return !(value < min) && !(max < value);
+        }
+        [[nodiscard]] std::string describe() const override {
+            return typeToString(min) + " and " + typeToString(max);
+        }
+    private:
+        T min;
+        T max;
+    };
+    std::vector<Constraint> constraints;
+    std::vector<WordMask> constraintMasks;
+    std::vector<std::unique_ptr<RangeCheck>> ranges;
+    // (argument, constraint) for every range, sorted, so a config file can check one argument's
+    // ranges without going through every constraint
+    std::vector<std::pair<size_t, size_t>> rangeConstraints;
+
+    size_t indexIn(const std::shared_ptr<const Argument> &arg) const {
+        if (arg == nullptr || arg->owner != this) {
+            throw std::invalid_argument(
+                "Only arguments added to this parser can be used in its constraints\n");
+        }
+        return arg->index;
+    }
+    void addConstraint(ParseError::Kind kind, size_t trigger, const Group &group, uint32_t least,
+        uint32_t most, ConstraintCount count) {
+        if (group.empty()) throw std::invalid_argument("Constraints can't have an empty group\n");
+        std::vector<size_t> members;
+        members.reserve(group.size());
+        for (const auto &arg : group) members.push_back(indexIn(arg));
+        std::sort(members.begin(), members.end());
+        members.erase(std::unique(members.begin(), members.end()), members.end());
+
+        Constraint constraint{kind, trigger, static_cast<uint32_t>(constraintMasks.size()), 0,
+            least, most, 0, count};
+        for (const size_t i : members) {
+            if (constraint.maskCount == 0 || constraintMasks.back().word != i / 64) {
+                constraintMasks.push_back(WordMask{i / 64, 0});
+                ++constraint.maskCount;
+            }
+            constraintMasks.back().bits |= uint64_t{1} << (i % 64);
+        }
+        constraints.push_back(constraint);
+    }
+    // the arguments in a constraint's group, for error messages
+    [[nodiscard]] std::string groupNames(const Constraint &constraint) const {
+        std::string names;
+        for (uint32_t m{0}; m < constraint.maskCount; ++m) {
+            const WordMask &mask = constraintMasks[constraint.firstMask + m];
+            detail::forEachBit(&mask.bits, 1, [&](size_t bit) {
+                names += (names.empty() ? "" : ", ")
+                         + arguments[mask.word * 64 + bit]->namesForErrors();
+            });
+        }
+        return names;
+    }
+    // checks every constraint against the results of a parse, in one pass, calling reject with
+    // each one that's broken. state returns an argument's state, or nullptr if it can't be read
+    // (because its deferred value turned out to be invalid)
+    template <typename State, typename Reject>
+    void checkConstraints(State state, const uint64_t *set, const uint64_t *fromEnv,
+        const uint64_t *defined, Reject &reject) const {
+        // one word of the arguments that count for a constraint
+        auto counted = [this, set, fromEnv, defined](const Constraint &constraint,
+                           size_t word) -> uint64_t {
+            if (constraint.count == COUNT_SET) return set[word];
+            return set[word] | fromEnv[word] | (defined[word] & ~defaultBits[word]);
+        };
+        auto report = [this, &reject](size_t c, size_t argument) {
+            ParseError error;
+            error.kind = constraints[c].kind;
+            error.argument = argument;
+            error.parser = this;
+            error.constraint = c;
+            reject(error);
+        };
+        for (size_t c{0}; c < constraints.size(); ++c) {
+            const Constraint &constraint = constraints[c];
+            if (constraint.kind == ParseError::OUT_OF_RANGE) {
+                if (!detail::testBit(defined, constraint.trigger)) continue;
+                const void *const value{state(constraint.trigger)};
+                if (value != nullptr && !ranges[constraint.range]->contains(value)) {
+                    report(c, constraint.trigger);
+                }
+                continue;
+            }
+            const size_t trigger{constraint.trigger};
+            if (trigger != ParseError::npos
+                && ((counted(constraint, trigger / 64) >> (trigger % 64)) & 1) == 0) {
+                continue;
+            }
+
+            const WordMask *const masks{constraintMasks.data() + constraint.firstMask};
+            size_t count{0};
+            for (uint32_t m{0}; m < constraint.maskCount; ++m) {
+                count += detail::popCount(counted(constraint, masks[m].word) & masks[m].bits);
+            }
+            if (count >= constraint.least && count <= constraint.most) continue;
+
+            size_t argument{constraint.trigger};
+            if (constraint.kind == ParseError::MUTUALLY_EXCLUSIVE) {
+                // the second one that counted is the one that broke it
+                size_t seen{0};
+                for (uint32_t m{0}; m < constraint.maskCount && seen < 2; ++m) {
+                    for (uint64_t bits{counted(constraint, masks[m].word) & masks[m].bits};
+                         bits != 0 && seen < 2; bits &= bits - 1) {
+                        if (++seen == 2) {
+                            argument = masks[m].word * 64 + detail::countTrailingZeros(bits);
+                        }
+                    }
+                }
+            }
+            else if (constraint.kind == ParseError::MISSING_REQUIRED) {
+                argument = masks[0].word * 64 + detail::countTrailingZeros(masks[0].bits);
+            }
+            report(c, argument);
+        }
+    }
+
+    // just the ranges, for a result that doesn't come from a command (see defaults)
+    template <typename State, typename Reject>
+    void checkRanges(State state, const uint64_t *defined, Reject &reject) const {
+        for (const auto &r : rangeConstraints) {
+            if (!detail::testBit(defined, r.first)) continue;
+            if (ranges[constraints[r.second].range]->contains(state(r.first))) continue;
+            ParseError error;
+            error.kind = ParseError::OUT_OF_RANGE;
+            error.argument = r.first;
+            error.parser = this;
+            error.constraint = r.second;
+            reject(error);
+        }
+    }
+
+    // environment variable bindings, sorted by name (without the prefix) when the parser is frozen
+    struct EnvBinding {
+        std::string name;
+        size_t index;
+    };
+    std::string envPrefix;
+    std::vector<EnvBinding> envBindings;
+
+    // sets arguments from a config file (see parseConfigFile), keeping the file mapped in files
+    template <typename State>
+    void readConfigFile(const std::string &path,
+        std::vector<std::unique_ptr<detail::MappedFile>> &files, State state, const uint64_t *set,
+        const uint64_t *fromEnv, uint64_t *defined) const {
+        std::unique_ptr<detail::MappedFile> file{new detail::MappedFile};
+        if (!file->open(path)) {
+            throw std::invalid_argument("Config file " + path + " couldn't be opened\n");
+        }
+        detail::ConfigReader reader{detail::keepMapped(files, std::move(file)), path};
+
+        StringView key, value;
+        while (reader.next(key, value)) {
+            const size_t i{index.find(key)};
+            if (i == NameIndex::npos || detail::testBit(set, i) || detail::testBit(fromEnv, i)) {
+                continue;
+            }
+            ParseError error;
+            if (parseFunctions[i](*arguments[i], state(i), false, value, true, error) == 0) {
+                reader.error("gives command-line argument " + arguments[i]->namesForErrors()
+                             + " an invalid value of \"" + value.str() + "\"");
+            }
+            // ranges are checked here, since the constraints were checked when the command was
+            // parsed
+            for (auto r = std::lower_bound(rangeConstraints.begin(), rangeConstraints.end(),
+                     std::make_pair(i, size_t{0}));
+                 r != rangeConstraints.end() && r->first == i; ++r) {
+                const RangeCheck &check = *ranges[constraints[r->second].range];
+                if (!check.contains(state(i))) {
+                    reader.error("gives command-line argument " + arguments[i]->namesForErrors()
+                                 + " a value of \"" + value.str() + "\", which isn't between "
+                                 + check.describe());
+                }
+            }
+            detail::setBit(defined, i);
+        }
+    }
+
+    // goes through the environment once, and gives every bound argument that wasn't set in the
+    // command the value of its variable, marking it in fromEnv (so config files leave it alone).
+    // nothing is copied, so StringView values point straight into the environment
+    template <typename State, typename Reject>
+    void applyEnv(State state, const uint64_t *set, uint64_t *fromEnv, uint64_t *defined,
+        Reject &reject) const {
+        if (envBindings.empty()) return;
+        char **variables{detail::environment()};
+        if (variables == nullptr) return;
+
+        // compares binding names to StringViews, so names from the environment aren't copied
+        struct Compare {
+            bool operator()(const EnvBinding &binding, StringView name) const {
+                return binding.name.compare(0, binding.name.length(), name.data(), name.length())
+                       < 0;
+            }
+            bool operator()(StringView name, const EnvBinding &binding) const {
+                return binding.name.compare(0, binding.name.length(), name.data(), name.length())
+                       > 0;
+            }
+        };
+        for (; *variables != nullptr; ++variables) {
+            const char *const variable{*variables};
+            if (std::strncmp(variable, envPrefix.c_str(), envPrefix.length()) != 0) continue;
+            const char *const name{variable + envPrefix.length()};
+            const char *const equals{std::strchr(name, '=')};
+            if (equals == nullptr) continue;
+
+            const StringView key{name, static_cast<size_t>(equals - name)};
+            const StringView value{equals + 1};
+            const auto range = std::equal_range(envBindings.begin(), envBindings.end(), key,
+                Compare{});
+            for (auto binding = range.first; binding != range.second; ++binding) {
+                const size_t i{binding->index};
+                if (detail::testBit(set, i)) continue; // the command takes precedence
+                ParseError error;
+                if (parseFunctions[i](*arguments[i], state(i), false, value, true, error) == 0) {
+                    error.kind = ParseError::INVALID_ENVIRONMENT_VALUE;
+                    error.argument = i;
+                    error.value = StringView{variable};
+                    error.parser = this;
+                    reject(error);
+                    continue;
+                }
+                detail::setBit(fromEnv, i);
+                detail::setBit(defined, i);
+            }
+        }
+    }
+
+    // attached is whether value came from the same token as the argument's name. this returns
+    // false (leaving the argument alone) if the value is invalid
+    bool applyArg(size_t i, void *state, uint64_t *set, uint64_t *defined, StringView value,
+        bool attached, ParseError &error) const {
+        if (kinds[i] == FLAG_KIND && !attached) {
+            *static_cast<bool *>(state) = true;
+            detail::setBit(set, i);
+            return true;
+        }
+        const unsigned marks{parseFunctions[i](*arguments[i], state, detail::testBit(set, i), value,
+            attached, error)};
+        if (marks & Argument::MARK_SET) detail::setBit(set, i);
+        if (marks & Argument::MARK_DEFINED) detail::setBit(defined, i);
+        return marks != 0;
+    }
+
+    // what parseCmd rejects errors with
+    struct Thrower {
+        const ArgParser *parser;
+        void operator()(const ParseError &error) const {
+            throw std::invalid_argument(parser->errorMessage(error));
+        }
+    };
+    // parseCmd and tryParseCmd. errors is where the token stream puts response file errors (or
+    // nullptr to have it throw them), and reject is called with every other error
+    template <typename Iterator, typename Reject>
+    void parseOwn(Iterator first, Iterator last, std::vector<ParseError> *errors, Reject reject) {
+        detail::TokenStream<Iterator> tokens{first, last, expandResponseFiles, responseFiles,
+            errors};
+        parseStream(tokens, reject);
+    }
+    // parses the rest of a stream, which a parent parser might have already started on
+    template <typename Stream, typename Reject>
+    void parseStream(Stream &tokens, Reject &reject) {
+        if (!frozen) freeze();
+
+        chosenSubcommand = NameIndex::npos;
+        detail::ParseRecorder recorder{makeRecorder()};
+        parseTokens(tokens, recorder,
+            [this](size_t i, StringView value, bool attached, ParseError &error) {
+                if (lazy) {
+                    if (kinds[i] == CALL_KIND && deferArg(i, value, attached)) return true;
+                    dropPending(i); // this value replaces the deferred one
+                }
+                return applyArg(i, ownStates[i], setBits.data(), definedBits.data(), value,
+                    attached, error);
+            },
+            reject,
+            [this, &reject](size_t subcommand, Stream &rest) {
+                chosenSubcommand = subcommand;
+                subcommandParser(subcommand).parseStream(rest, reject);
+            },
+            restTokens);
+        applyEnv([this](size_t i) { return ownStates[i]; }, setBits.data(), envBits.data(),
+            definedBits.data(), reject);
+        checkConstraints(
+            [this, &reject](size_t i) -> const void * {
+                ParseError error;
+                if (!detail::testBit(pendingBits.data(), i) || convertPending(i, error)) {
+                    return ownStates[i];
+                }
+                error.argument = i;
+                error.parser = this;
+                reject(error);
+                return nullptr;
+            },
+            setBits.data(), envBits.data(), definedBits.data(), reject);
+        recorder.finish();
+    }
+
+    // every response file (and config file) that's been read is kept mapped, since StringView
+    // values can point into them. each file is only kept once, however many times it's read
+    bool expandResponseFiles{false};
+    std::vector<std::unique_ptr<detail::MappedFile>> responseFiles;
+
+    // subcommands, in the order they were added. each one's parser is only built when it's needed
+    struct Subcommand {
+        std::string name;
+        std::string description;
+        std::function<void(ArgParser &)> registerArgs;
+        std::unique_ptr<ArgParser> parser;
+    };
+    std::vector<Subcommand> subcommands;
+    NameIndex subcommandIndex;
+    size_t chosenSubcommand{NameIndex::npos};
+
+    // snapshots start with these five words, followed by the set and defined bitsets, then the
+    // state of every argument, and then the chosen subcommand's parser's snapshot (if there is one)
+    enum : uint32_t {
+        SNAPSHOT_MAGIC = 0x4e534143, // "CASN" in little-endian order
+        SNAPSHOT_VERSION = 1,
+        NO_SUBCOMMAND = ~uint32_t{0}
+    };
+    // changes if the arguments' names, kinds, or value types do (each argument's snapshotTag says
+    // what kind it is and how its value is written, along with the size and alignment of its
+    // state), so a snapshot from a different parser (or a different build of the same program) is
+    // rejected instead of misread. it's worked out when the parser is frozen
+    uint32_t fingerprint{0};
+    [[nodiscard]] uint32_t schemaFingerprint() const {
+        uint32_t hash{2166136261u};
+        auto mix = [&hash](const void *bytes, size_t length) {
+            for (size_t i{0}; i < length; ++i) {
+                hash ^= static_cast<const unsigned char *>(bytes)[i];
+                hash *= 16777619u;
+            }
+        };
+        for (const Argument *arg : arguments) {
+            // the null terminators keep "-a" + "--bc" from matching "-a-" + "-bc"
+            mix(arg->shortName.data(), arg->shortName.length());
+            mix("", 1);
+            mix(arg->longName.data(), arg->longName.length());
+            mix("", 1);
+            const uint64_t layout[]{arg->stateSize(), arg->stateAlignment(), arg->snapshotTag()};
+            mix(layout, sizeof(layout));
+        }
+        return hash;
+    }
+    void writeSnapshot(std::string &out) const {
+        const uint32_t subcommand{chosenSubcommand != NameIndex::npos
+                                      ? static_cast<uint32_t>(chosenSubcommand)
+                                      : NO_SUBCOMMAND};
+        const uint32_t header[]{SNAPSHOT_MAGIC, SNAPSHOT_VERSION,
+            static_cast<uint32_t>(arguments.size()), frozen ? fingerprint : schemaFingerprint(),
+            subcommand};
+        detail::writeRaw(out, header, sizeof(header));
+        detail::writeRaw(out, setBits.data(), setBits.size() * sizeof(uint64_t));
+        detail::writeRaw(out, definedBits.data(), definedBits.size() * sizeof(uint64_t));
+        for (size_t i{0}; i < arguments.size(); ++i) {
+            if (snapshotSizes[i] != 0) { detail::writeRaw(out, ownStates[i], snapshotSizes[i]); }
+            else if (kinds[i] == FLAG_KIND) {
+                detail::SnapshotCodec<bool>::write(out, *static_cast<const bool *>(ownStates[i]));
+            }
+            else arguments[i]->writeSnapshot(ownStates[i], out);
+        }
+        if (subcommand != NO_SUBCOMMAND) subcommands[chosenSubcommand].parser->writeSnapshot(out);
+    }
+    bool readSnapshot(StringView &in) {
+        if (!frozen) freeze();
+        uint32_t header[5];
+        if (!detail::readRaw(in, header, sizeof(header)) || header[0] != SNAPSHOT_MAGIC
+            || header[1] != SNAPSHOT_VERSION || header[2] != arguments.size()
+            || header[3] != fingerprint
+            || (header[4] != NO_SUBCOMMAND && header[4] >= subcommands.size())) {
+            return false;
+        }
+        // every argument's state is replaced below, so this is all that's left of a reset
+        dropAllPending();
+        std::fill(envBits.begin(), envBits.end(), uint64_t{0});
+        chosenSubcommand = NameIndex::npos;
+        for (Subcommand &sub : subcommands) {
+            if (sub.parser != nullptr) sub.parser->reset();
+        }
+        restTokens.clear();
+        responseFiles.clear();
+        if (!detail::readRaw(in, setBits.data(), setBits.size() * sizeof(uint64_t))
+            || !detail::readRaw(in, definedBits.data(), definedBits.size() * sizeof(uint64_t))) {
+            return false;
+        }
+        // flags can't be copied straight in (their bytes have to be checked), but they're still
+        // read here instead of through the vtable
+        for (size_t i{0}; i < arguments.size(); ++i) {
+            bool read;
+            if (snapshotSizes[i] != 0) {
+                read = detail::readRaw(in, ownStates[i], snapshotSizes[i]);
+            }
+            else if (kinds[i] == FLAG_KIND) {
+                read = detail::SnapshotCodec<bool>::read(in, *static_cast<bool *>(ownStates[i]));
+            }
+            else read = arguments[i]->readSnapshot(ownStates[i], in);
+            if (!read) return false;
+        }
+        if (header[4] == NO_SUBCOMMAND) return true;
+        chosenSubcommand = header[4];
+        return subcommandParser(chosenSubcommand).readSnapshot(in);
+    }
+
+    ArgParser &subcommandParser(size_t i) {
+        Subcommand &sub = subcommands[i];
+        if (sub.parser == nullptr) {
+            std::unique_ptr<ArgParser> parser{new ArgParser{storage}};
+            sub.registerArgs(*parser);
+            sub.parser = std::move(parser);
+        }
+        return *sub.parser;
+    }
+
+    // everything in a help message that takes any work to figure out. it's rebuilt the first time
+    // a help message is created after an argument is added
+    struct HelpColumns {
+        size_t longestShortName{0};
+        size_t longestLongName{0};
+        size_t longestDefaultValue{0};
+    };
+    size_t longestSubcommand{0};
+    size_t longestPositional{0}; // including the angle brackets and the default value
+    bool helpCached{false};
+    std::vector<std::string> helpDefaults; // each argument's default as a string, by index
+    std::vector<std::string> helpChoices; // each argument's choices as a string, by index
+    HelpColumns visibleColumns; // widths for just the visible arguments
+    HelpColumns allColumns; // widths for the visible and hidden arguments
+
+    void cacheHelp() {
+        helpDefaults.clear();
+        helpDefaults.reserve(arguments.size());
+        helpChoices.clear();
+        helpChoices.reserve(arguments.size());
+        for (const Argument *arg : arguments) {
+            helpDefaults.push_back(arg->getDefaultAsString());
+            helpChoices.push_back(arg->choicesAsString());
+        }
+
+        // find the longest names and the longest default value, and also check them with the
+        // hidden arguments for when those are enabled
+        auto measure = [this](const std::vector<Argument *> &args, HelpColumns &columns) {
+            for (const Argument *arg : args) {
+                columns.longestShortName = std::max(columns.longestShortName,
+                    arg->shortName.length());
+                columns.longestLongName = std::max(columns.longestLongName, arg->longName.length());
+                columns.longestDefaultValue = std::max(columns.longestDefaultValue,
+                    helpDefaults[arg->index].length());
+            }
+        };
+        visibleColumns = HelpColumns{};
+        measure(visibleArgs, visibleColumns);
+        allColumns = visibleColumns;
+        measure(hiddenArgs, allColumns);
+        longestSubcommand = 0;
+        for (const Subcommand &sub : subcommands) {
+            longestSubcommand = std::max(longestSubcommand, sub.name.length());
+        }
+        longestPositional = 0;
+        for (const size_t i : positionals) {
+            longestPositional = std::max(longestPositional,
+                arguments[i]->positionalName.length() + 3 + helpDefaults[i].length());
+        }
+
+        helpCached = true;
+    }
+
+    // passes the help message to write in pieces, as (pointer, length) pairs
+    template <typename Write>
+    void writeHelpMessage(bool showHidden, Write write) {
+        if (!helpCached) cacheHelp();
+        const HelpColumns &columns = showHidden ? allColumns : visibleColumns;
+
+        auto writeString = [&write](StringView str) { write(str.data(), str.length()); };
+        auto pad = [&write](size_t count) {
+            static const char spaces[]{"                                "};
+            for (; count > sizeof(spaces) - 1; count -= sizeof(spaces) - 1) {
+                write(spaces, sizeof(spaces) - 1);
+            }
+            write(spaces, count);
+        };
+        auto writeArgs = [&](const std::vector<Argument *> &args) {
+            for (const Argument *arg : args) {
+                // the long name and the default value are merged together to make formatting work
+                const std::string &defaultValue = helpDefaults[arg->index];
+                write("  ", 2);
+                pad(columns.longestShortName - arg->shortName.length());
+                writeString(arg->shortName);
+                write(", ", 2);
+                writeString(arg->longName);
+                write(" ", 1);
+                writeString(defaultValue);
+                pad(columns.longestLongName + columns.longestDefaultValue - arg->longName.length()
+                    - defaultValue.length());
+                write("  ", 2);
+                writeString(arg->description);
+                const std::string &choices = helpChoices[arg->index];
+                if (!choices.empty()) {
+                    write(" (one of ", 9);
+                    writeString(choices);
+                    write(")", 1);
+                }
+                write("\n", 1);
+            }
+        };
+
+        write("[[Allowed Arguments]]\n", 22);
+        writeArgs(visibleArgs);
+
+        // print the hidden arguments if they're enabled
+        if (showHidden) {
+            write("[[Hidden Arguments]]\n", 21);
+            writeArgs(hiddenArgs);
+        }
+
+        if (!positionals.empty()) {
+            write("[[Positional Arguments]]\n", 25);
+            for (const size_t i : positionals) {
+                const Argument *arg = arguments[i];
+                const std::string &defaultValue = helpDefaults[i];
+                write("  <", 3);
+                writeString(arg->positionalName);
+                write("> ", 2);
+                writeString(defaultValue);
+                pad(longestPositional - arg->positionalName.length() - 3 - defaultValue.length());
+                write("  ", 2);
+                writeString(arg->description);
+                const std::string &choices = helpChoices[i];
+                if (!choices.empty()) {
+                    write(" (one of ", 9);
+                    writeString(choices);
+                    write(")", 1);
+                }
+                write("\n", 1);
+            }
+        }
+
+        // subcommands are listed by name and description, so their parsers don't have to be built
+        if (!subcommands.empty()) {
+            write("[[Subcommands]]\n", 16);
+            for (const Subcommand &sub : subcommands) {
+                write("  ", 2);
+                writeString(sub.name);
+                pad(longestSubcommand - sub.name.length());
+                write("  ", 2);
+                writeString(sub.description);
+                write("\n", 1);
+            }
+        }
+    }
+
+    // where each argument's state goes in a ParseResult, in the same order as arguments
+    friend class ParseResult;
+    std::vector<size_t> stateOffsets;
+    size_t stateBytes{0};
+
+    template <typename Iterator>
+    void parseInto(ParseResult &result, Iterator first, Iterator last) const;
+    // a result holding every argument's default (and whatever the environment gives it), for a
+    // ReloadableResult to start out with. no command was given, so the only constraints that are
+    // checked are ranges (a required argument isn't missing from a command nobody has given yet)
+    friend class ReloadableResult;
+    ParseResult defaults() const;
+
+    // what parseTokens gives applyCompound: everything it needs to apply an argument and reject
+    // an invalid value
+    template <typename Apply, typename Reject>
+    struct Scan {
+        const ArgParser *parser;
+        detail::ParseRecorder &recorder;
+        Apply &apply;
+        Reject &reject;
+        size_t position; // where the current token is in the command
+        bool nextIsValue; // whether the next token is the value of the last argument
+        size_t positionals; // how many positional arguments have been given a token
 
-// predefinition for friending
-class ArgParser;
+        void hit(size_t i, StringView value, bool attached) {
+            recorder.hit(i, value, [&] {
+                ParseError error;
+                if (apply(i, value, attached, error)) return;
+                error.argument = i;
+                error.token = position;
+                error.parser = parser;
+                reject(error);
+            });
+            nextIsValue = !attached && parser->kinds[i] != FLAG_KIND;
+        }
+    };
 
-// base class for arguments
-class Argument {
-public:
-    Argument(const Visibility visibility, const std::string &shortName, const std::string &longName,
-        std::string description) :
-        shortName{(!shortName.empty()) ? ("-" + shortName) : ("")},
-        longName{(!longName.empty()) ? ("--" + longName) : ""},
-        visibility{visibility}, description{std::move(description)} {
+    // the loop shared by every kind of parse. apply is called with the index of each argument
+    // that's named in the command, its value, whether the value was attached to the name, and an
+    // error to fill in, and returns false if the value was invalid. reject is called with every
+    // error, and either throws or records it. every name starts with a dash, so a token that
+    // doesn't (or is just "-") is never looked up: it's a value, a subcommand, a positional
+    // argument, or one for rest. tokens that are looked up are only split up (by applyCompound)
+    // after the lookup misses, so commands that don't use --name=value or -xvf don't pay anything
+    // for them. a token that doesn't turn out to name anything is a positional argument if it
+    // looks like a negative number, and one for rest otherwise. when a subcommand's name is
+    // reached, enter is called with the subcommand and the rest of the stream, and this stops
+    template <typename Stream, typename Apply, typename Reject, typename Enter>
+    void parseTokens(Stream &tokens, detail::ParseRecorder &recorder, Apply apply, Reject reject,
+        Enter enter, detail::RestTokens &rest) const {
+        Scan<Apply, Reject> scan{this, recorder, apply, reject, tokens.position(), false, 0};
+        StringView token, next;
+        bool hasToken{tokens.next(token)};
+        for (; hasToken; ++scan.position) {
+            // this is checked before the next token is read, so it doesn't get expanded if it's
+            // an @path
+            if (token.length() == 2 && token[0] == '-' && token[1] == '-') {
+                recorder.token();
+                parseAfterTerminator(tokens, scan, rest);
+                return;
+            }
+            const bool hasNext{tokens.next(next)};
+            recorder.token();
+            const bool isValue{scan.nextIsValue};
+            scan.nextIsValue = false;
+
+            // i don't actually know if it's possible for an empty string to end up in argv, but
+            // i'm also not going to risk it
+            if (!token.empty() && (token[0] != '-' || token.length() == 1)) {
+                size_t i;
+                if (isValue) { recorder.miss(token); }
+                else if (!subcommands.empty()
+                         && (i = subcommandIndex.find(token)) != NameIndex::npos) {
+                    if (hasNext) tokens.putBack(next);
+                    enter(i, tokens);
+                    return;
+                }
+                else if (scan.positionals < positionals.size()) {
+                    scan.hit(positionals[scan.positionals++], token, true);
+                }
+                else {
+                    recorder.miss(token);
+                    rest.add(token);
+                }
+            }
+            else if (!token.empty()) {
+                size_t i{index.find(token)};
+                if (i == NameIndex::npos && abbreviations) {
+                    i = findAbbreviation(token, scan.position, reject);
+                }
+                if (i != NameIndex::npos) { scan.hit(i, hasNext ? next : StringView{}, false); }
+                else if (!applyCompound(token, hasNext ? next : StringView{}, scan)) {
+                    // it isn't a name after all. a negative number can still be a positional
+                    // argument, and anything else goes to rest so it isn't lost
+                    if (scan.positionals < positionals.size() && looksNegative(token)) {
+                        scan.hit(positionals[scan.positionals++], token, true);
+                    }
+                    else {
+                        recorder.miss(token);
+                        rest.add(token);
+                    }
+                }
+            }
+
+            token = next;
+            hasToken = hasNext;
+        }
     }
-    Argument(const std::string &shortName, const std::string &longName, std::string description) :
-        Argument(VISIBLE, shortName, longName, std::move(description)) {
+    // after "--", the tokens just fill in the positional arguments that are still empty (and
+    // values that start with a dash are fine), and whatever's left goes into rest all at once
+    template <typename Stream, typename ScanType>
+    void parseAfterTerminator(Stream &tokens, ScanType &scan, detail::RestTokens &rest) const {
+        StringView token;
+        while (scan.positionals < positionals.size() && tokens.next(token, false)) {
+            ++scan.position;
+            scan.recorder.token();
+            scan.hit(positionals[scan.positionals++], token, true);
+        }
+        rest.take(tokens);
     }
 
-    virtual ~Argument() = default;
+    // handles --name=value, and clusters of short names like -xvf. every name in a cluster has to
+    // be a one-character short name, and the first one that isn't a flag takes the rest of the
+    // token as its value (-j8), or the next token if nothing is left. nothing is applied unless the
+    // whole token makes sense, and this returns false if it doesn't. the names are looked up as
+    // views into the token (or a two-character buffer), so this never allocates
+    template <typename ScanType>
+    bool applyCompound(StringView token, StringView next, ScanType &scan) const {
+        if (token.length() < 3 || token[0] != '-') return false;
+        if (token[1] == '-') {
+            const char *const equals{detail::findByte(token.begin() + 2, token.end(), '=')};
+            if (equals == token.end()) return false;
+            const StringView name{token.data(), static_cast<size_t>(equals - token.begin())};
+            size_t i{index.find(name)};
+            if (i == NameIndex::npos && abbreviations) {
+                i = findAbbreviation(name, scan.position, scan.reject);
+            }
+            if (i == NameIndex::npos) return false;
+            const StringView value{equals + 1, static_cast<size_t>(token.end() - equals - 1)};
+            scan.hit(i, value, true);
+            return true;
+        }
 
-    [[nodiscard]] bool isSet() const {
-        return isSet_;
+        // check the whole cluster before applying any of it
+        size_t valuePos{1};
+        for (; valuePos < token.length(); ++valuePos) {
+            const size_t i{findShort(token[valuePos])};
+            if (i == NameIndex::npos) return false;
+            if (kinds[i] != FLAG_KIND) break;
+        }
+        for (size_t pos{1}; pos < token.length() && pos <= valuePos; ++pos) {
+            const size_t i{findShort(token[pos])};
+            if (pos < valuePos) { scan.hit(i, StringView{}, false); }
+            else if (pos + 1 < token.length()) {
+                scan.hit(i, StringView{token.data() + pos + 1, token.length() - pos - 1}, true);
+            }
+            else scan.hit(i, next, false);
+        }
+        return true;
     }
-    [[nodiscard]] bool isDefined() const {
-        return isDefined_;
+    size_t findShort(char c) const {
+        const char name[2]{'-', c};
+        return index.find(StringView{name, 2});
+    }
+    // -5, -0.5, or -.5 (the rest of the token is left for the argument to check)
+    static bool looksNegative(StringView token) {
+        const size_t digit{token.length() > 2 && token[1] == '.' ? size_t{2} : size_t{1}};
+        return token.length() > digit && token[digit] >= '0' && token[digit] <= '9';
     }
 
-    const std::string shortName;
-    const std::string longName;
-    const std::string description;
-    const Visibility visibility;
+    // used to separate argument visibilities in help messages (and to print arguments in order)
+    std::vector<Argument *> visibleArgs;
+    std::vector<Argument *> hiddenArgs;
+    std::vector<size_t> positionals; // the positional arguments, in the order they're filled in
+    detail::RestTokens restTokens;
 
-protected:
-    friend class ArgParser;
-    // true only if the value was set in the command, not if it was set with a default value
-    bool isSet_{false};
-    bool isDefined_{false}; // true if the value was set in the command or with a default value
-    virtual void parseArg(const char *arg) = 0;
-    virtual std::string getDefaultAsString() = 0; // used for printing a help message
+#if CMD_ARGS_STATS
+    ParseStats stats_;
+    ParseHooks *hooks{nullptr};
+#endif
+    // a recorder for parseCmd, and one for parse()
+    detail::ParseRecorder makeRecorder();
+    detail::ParseRecorder makeRecorder(ParseResult &result) const;
 };
-
-// ValueArgs can (but don't have to) have a default value, and can be set in the commmand
-// if they are set in the command, they must be accompannied by a value (even if they have a
-// default value)
-template <typename T>
-class [[maybe_unused]] ValueArg : public Argument {
+// the results of ArgParser::parse(). each one holds its own copy of every argument's state, laid
+// out in one block, so any number of them can exist at once without touching the arguments
+class ParseResult {
 public:
-    // ctors
-    ValueArg(const Visibility visibility, const std::string &shortName, const std::string &longName,
-        const std::string &description) :
-        Argument(visibility, shortName, longName, description) {
-    }
-    ValueArg(const Visibility visibility, const std::string &shortName, const std::string &longName,
-        const std::string &description, const T &defaultValue) :
-        Argument(visibility, shortName, longName, description) {
-        data = defaultValue;
-        dv = defaultValue;
-        isDefined_ = true;
-        hasDefault_ = true;
+    ParseResult(const ParseResult &) = delete;
+    ParseResult &operator=(const ParseResult &) = delete;
+    ParseResult(ParseResult &&other) noexcept :
+        parser{other.parser}, count{other.count}, states{other.states},
+        setBits{std::move(other.setBits)}, definedBits{std::move(other.definedBits)},
+        envBits{std::move(other.envBits)}, responseFiles{std::move(other.responseFiles)},
+        restTokens{std::move(other.restTokens)},
+        subcommand_{other.subcommand_} {
+#if CMD_ARGS_STATS
+        stats_ = std::move(other.stats_);
+#endif
+        other.states = nullptr;
+        other.count = 0;
     }
-    ValueArg(const std::string &shortName, const std::string &longName,
-        const std::string &description) :
-        ValueArg(VISIBLE, shortName, longName, description) {
+    ParseResult &operator=(ParseResult &&other) noexcept {
+        if (this != &other) {
+            destroy();
+            parser = other.parser;
+            count = other.count;
+            states = other.states;
+            setBits = std::move(other.setBits);
+            definedBits = std::move(other.definedBits);
+            envBits = std::move(other.envBits);
+            responseFiles = std::move(other.responseFiles);
+            restTokens = std::move(other.restTokens);
+            subcommand_ = other.subcommand_;
+#if CMD_ARGS_STATS
+            stats_ = std::move(other.stats_);
+#endif
+            other.states = nullptr;
+            other.count = 0;
+        }
+        return *this;
     }
-    ValueArg(const std::string &shortName, const std::string &longName,
-        const std::string &description, const T &defaultValue) :
-        ValueArg(VISIBLE, shortName, longName, description, defaultValue) {
+    ~ParseResult() {
+        destroy();
     }
 
-    T value() const {
-        return data;
+    // puts every state back to its default, keeping whatever memory strings and vectors already
+    // had. parse(result, first, last) does this automatically
+    void reset() {
+        for (size_t i{0}; i < count; ++i) parser->arguments[i]->resetState(state(i));
+        std::fill(setBits.begin(), setBits.end(), uint64_t{0});
+        std::copy(parser->defaultBits.begin(), parser->defaultBits.begin()
+            + static_cast<std::ptrdiff_t>(definedBits.size()), definedBits.begin());
+        std::fill(envBits.begin(), envBits.end(), uint64_t{0});
+        restTokens.clear();
+        responseFiles.clear();
+        subcommand_ = NameIndex::npos;
+#if CMD_ARGS_STATS
+        stats_ = ParseStats{};
+#endif
     }
-    [[nodiscard]] bool hasDefault() const {
-        return hasDefault_;
+
+    // these work like the argument methods with the same names
+    [[nodiscard]] bool isSet(const Argument &arg) const {
+        return detail::testBit(setBits.data(), indexOf(arg));
     }
-    // returns the argument's default value
-    T defaultValue() const {
-        return dv;
+    [[nodiscard]] bool isDefined(const Argument &arg) const {
+        return detail::testBit(definedBits.data(), indexOf(arg));
+    }
+    template <typename ArgType>
+    const typename ArgType::ValueType &value(const ArgType &arg) const {
+        return *static_cast<const typename ArgType::ValueType *>(state(indexOf(arg)));
+    }
+
+    // overloads for the pointers returned by ArgParser::add
+    template <typename ArgType>
+    [[nodiscard]] bool isSet(const std::shared_ptr<ArgType> &arg) const {
+        return isSet(*arg);
+    }
+    template <typename ArgType>
+    [[nodiscard]] bool isDefined(const std::shared_ptr<ArgType> &arg) const {
+        return isDefined(*arg);
+    }
+    template <typename ArgType>
+    const typename ArgType::ValueType &value(const std::shared_ptr<ArgType> &arg) const {
+        return value(*arg);
     }
+
+    // these work like the parser methods with the same names
+    [[nodiscard]] size_t setCount() const {
+        return detail::countBits(setBits.data(), setBits.size());
+    }
+    template <typename Function>
+    void forEachSet(Function f) const {
+        detail::forEachBit(setBits.data(), setBits.size(),
+            [this, &f](size_t i) { f(static_cast<const Argument &>(*parser->arguments[i])); });
+    }
+    // parse() never builds a subcommand's parser (since it never modifies the parser), so it just
+    // stops at a subcommand's name. this returns that name (or an empty view if there wasn't one),
+    // and the rest of the command can be parsed with the subcommand's parser
+    [[nodiscard]] StringView subcommand() const {
+        if (subcommand_ == NameIndex::npos) return {};
+        return parser->subcommands[subcommand_].name;
+    }
+    // works like ArgParser::rest, for the command that was parsed into this result
+    [[nodiscard]] TokenSpan rest() const {
+        return restTokens.span();
+    }
+#if CMD_ARGS_STATS
+    // the stats for the parse that produced this result
+    [[nodiscard]] const ParseStats &stats() const {
+        return stats_;
+    }
+#endif
 private:
     friend class ArgParser;
-    T data, dv;
-    bool hasDefault_{false};
-    void parseArg(const char *arg) override {
-        // error check for no parameter
-        if (arg[0] == '-') {
-            // completely unnecessary ternary here to make error messages look a little prettier
-            throw std::invalid_argument("Command-line argument " + shortName
-                                        + (!shortName.empty() && !longName.empty() ? "/" : "")
-                                        + longName + " requires a value but none was given\n");
-        }
+    const ArgParser *parser;
+    size_t count; // how many states there are, in case the parser gets more arguments later
+    unsigned char *states;
+    std::vector<uint64_t> setBits;
+    std::vector<uint64_t> definedBits;
+    std::vector<uint64_t> envBits;
+    std::vector<std::unique_ptr<detail::MappedFile>> responseFiles;
+    detail::RestTokens restTokens;
+    size_t subcommand_{NameIndex::npos};
+#if CMD_ARGS_STATS
+    ParseStats stats_;
+#endif
 
+    // creates a result holding every argument's default state
+    explicit ParseResult(const ArgParser &parser) :
+        parser{&parser}, count{0}, states{nullptr}, setBits((parser.arguments.size() + 63) / 64),
+        definedBits(parser.defaultBits), envBits(setBits.size()) {
+        states = static_cast<unsigned char *>(
+            ::operator new(parser.stateBytes != 0 ? parser.stateBytes : 1));
         try {
-            data = stringToType<T>(arg);
-        } catch (
-            std::invalid_argument &err) { // rethrow the error with a more informative description
-            throw std::invalid_argument("Command-line argument " + shortName
-                                        + (!shortName.empty() && !longName.empty() ? "/" : "")
-                                        + longName + " recieved an invalid value of \"" + arg
-                                        + "\"\n");
+            for (; count < parser.arguments.size(); ++count) {
+                parser.arguments[count]->constructState(states + parser.stateOffsets[count]);
+            }
+        } catch (...) {
+            destroy();
+            throw;
         }
     }
 
-    // *attempts* to return the default value (if it exists) as a string.
-    std::string getDefaultAsString() override {
-        if (!hasDefault_) return "";
-        return {"=" + typeToString(data)};
+    void destroy() {
+        for (size_t i{count}; i > 0; --i) {
+            parser->arguments[i - 1]->destroyState(states + parser->stateOffsets[i - 1]);
+        }
+        ::operator delete(states);
+        states = nullptr;
+        count = 0;
+    }
+
+    size_t indexOf(const Argument &arg) const {
+        if (arg.owner != parser || arg.index >= count) {
+            throw std::invalid_argument("Command-line argument " + arg.namesForErrors()
+                                        + " isn't part of the parser this result came from\n");
+        }
+        return arg.index;
+    }
+    void *state(size_t i) const {
+        return states + parser->stateOffsets[i];
     }
 };
 
-// ImplicitArgs must have a default value, but are undefined unless they appear in the command
-// if they appear in the command and are given a value, they are equal to that value,
-// otherwise they are equal to their default value
-template <typename T>
-class [[maybe_unused]] ImplicitArg : public Argument {
-public:
-    // ctor without default value
-    ImplicitArg(const Visibility visibility, const std::string &shortName,
-        const std::string &longName, const std::string &description, const T &sv) :
-        Argument(visibility, shortName, longName, description) {
-        setValue = sv;
+#if CMD_ARGS_STATS
+inline detail::ParseRecorder ArgParser::makeRecorder() {
+    return detail::ParseRecorder{stats_, hooks, arguments};
+}
+inline detail::ParseRecorder ArgParser::makeRecorder(ParseResult &result) const {
+    return detail::ParseRecorder{result.stats_, hooks, arguments};
+}
+#else
+inline detail::ParseRecorder ArgParser::makeRecorder() {
+    return detail::ParseRecorder{};
+}
+inline detail::ParseRecorder ArgParser::makeRecorder(ParseResult &) const {
+    return detail::ParseRecorder{};
+}
+#endif
+
+inline void Argument::resolve() const {
+    if (!pending) return;
+    if (owner != nullptr) {
+        owner->resolveArg(index);
+        return;
     }
-    // ctor with default value
-    ImplicitArg(const Visibility visibility, const std::string &shortName,
-        const std::string &longName, const std::string &description, const T &sv, const T &dv) :
-        Argument(visibility, shortName, longName, description) {
-        setValue = sv;
-        data = dv;
-        hasDefault_ = true;
-        isDefined_ = true;
+    // the parser is gone, but the value is still the argument's to convert
+    ParseError error;
+    if (parseValue(const_cast<Argument *>(this)->ownState(), false, pendingValue, true, error)
+        == 0) {
+        throw std::invalid_argument(errorMessage(error));
     }
-    ImplicitArg(const std::string &shortName, const std::string &longName,
-        const std::string &description, const T &sv) :
-        ImplicitArg(VISIBLE, shortName, longName, description, sv) {
+    pending = false;
+}
+inline bool Argument::isSet() const {
+    if (owner == nullptr) return detachedSet;
+    return detail::testBit(owner->setBits.data(), index);
+}
+inline bool Argument::isDefined() const {
+    if (owner == nullptr) return definedByDefault_ || detachedDefined;
+    return detail::testBit(owner->definedBits.data(), index);
+}
+
+inline ParseResult ArgParser::parse(int argc, const char **argv) const {
+    return parse(argv + (argc > 0 ? 1 : 0), argv + argc);
+}
+template <typename Iterator>
+ParseResult ArgParser::parse(Iterator first, Iterator last) const {
+    if (!frozen) {
+        throw std::logic_error("ArgParser::parse() requires the parser to be frozen first\n");
     }
-    ImplicitArg(const std::string &shortName, const std::string &longName,
-        const std::string &description, const T &sv, const T &dv) :
-        ImplicitArg(VISIBLE, shortName, longName, description, sv, dv) {
+    ParseResult result{*this};
+    parseInto(result, first, last);
+    return result;
+}
+template <typename Tokens>
+ParseResult ArgParser::parse(const Tokens &tokens) const {
+    return parse(std::begin(tokens), std::end(tokens));
+}
+inline ParseResult ArgParser::parse(std::initializer_list<StringView> tokens) const {
+    return parse(tokens.begin(), tokens.end());
+}
+template <typename Iterator>
+void ArgParser::parse(ParseResult &result, Iterator first, Iterator last) const {
+    if (!frozen) {
+        throw std::logic_error("ArgParser::parse() requires the parser to be frozen first\n");
     }
+    if (result.parser != this || result.count != arguments.size()) {
+        // the result came from somewhere else (or the parser has changed), so start over
+        result = ParseResult{*this};
+    }
+    else { result.reset(); }
+    parseInto(result, first, last);
+}
 
-    T value() const {
-        return data;
+template <typename Iterator>
+void ArgParser::parseInto(ParseResult &result, Iterator first, Iterator last) const {
+    detail::TokenStream<Iterator> tokens{first, last, expandResponseFiles, result.responseFiles};
+    detail::ParseRecorder recorder{makeRecorder(result)};
+    const Thrower reject{this};
+    parseTokens(tokens, recorder,
+        [this, &result](size_t i, StringView value, bool attached, ParseError &error) {
+            return applyArg(i, result.state(i), result.setBits.data(), result.definedBits.data(),
+                value, attached, error);
+        },
+        reject,
+        [&result](size_t subcommand, detail::TokenStream<Iterator> &) {
+            result.subcommand_ = subcommand;
+        },
+        result.restTokens);
+    applyEnv([&result](size_t i) { return result.state(i); }, result.setBits.data(),
+        result.envBits.data(), result.definedBits.data(), reject);
+    checkConstraints([&result](size_t i) -> const void * { return result.state(i); },
+        result.setBits.data(), result.envBits.data(), result.definedBits.data(), reject);
+    recorder.finish();
+}
+
+inline ParseResult ArgParser::defaults() const {
+    if (!frozen) {
+        throw std::logic_error("ReloadableResult requires the parser to be frozen first\n");
     }
-    T defaultSetValue() const {
-        return setValue;
+    ParseResult result{*this};
+    const Thrower reject{this};
+    applyEnv([&result](size_t i) { return result.state(i); }, result.setBits.data(),
+        result.envBits.data(), result.definedBits.data(), reject);
+    checkRanges([&result](size_t i) -> const void * { return result.state(i); },
+        result.definedBits.data(), reject);
+    return result;
+}
+
+inline void ArgParser::parseConfigFile(ParseResult &result, const std::string &path) const {
+    if (!frozen) {
+        throw std::logic_error(
+            "ArgParser::parseConfigFile() requires the parser to be frozen first to parse into a "
+            "ParseResult\n");
     }
-    [[nodiscard]] bool hasDefault() const {
-        return hasDefault_;
+    readConfigFile(path, result.responseFiles, [&result](size_t i) { return result.state(i); },
+        result.setBits.data(), result.envBits.data(), result.definedBits.data());
+}
+
+// holds the current ParseResult for a parser whose options can change while the program is running
+// (like a service that re-reads them when it gets a SIGHUP). a reload builds a whole new result
+// with parse() and parseConfigFile(result, path), ahead of time and without touching the old one,
+// and publish() swaps it in with a single atomic store, so readers see either the old values or
+// the new ones and never a mix of the two. readers never lock anything: each reading thread
+// registers a Reader, and a read is one store to the reader's own slot and two atomic loads.
+// an old result is only deleted once no reader can still be looking at it (every reader that was
+// reading when it was replaced has finished), which is checked every time a result is published
+class ReloadableResult {
+public:
+    // starts out with a result holding every argument's default value (and whatever the
+    // environment gives them). that isn't a command, so the parser's constraints aren't checked
+    // (except for ranges), and a required argument doesn't make this throw. the parser has to be
+    // frozen, and has to outlive this
+    explicit ReloadableResult(const ArgParser &parser) :
+        current{new ParseResult{parser.defaults()}} {
+    }
+    // starts out with a result that's already been parsed (and checked), like one for the command
+    // the program was started with
+    explicit ReloadableResult(ParseResult initial) :
+        current{new ParseResult{std::move(initial)}} {
+    }
+    ReloadableResult(const ReloadableResult &) = delete;
+    ReloadableResult &operator=(const ReloadableResult &) = delete;
+    // every Reader has to be destroyed first
+    ~ReloadableResult() {
+        delete current.load();
+        for (const Retired &old : retired) delete old.result;
+    }
+
+    // makes result the current one. this can be called from any thread (calls to it are serialized
+    // with each other, but never wait for readers), and it deletes any old results that nothing
+    // can be reading anymore
+    void publish(ParseResult result) {
+        std::unique_ptr<ParseResult> fresh{new ParseResult{std::move(result)}};
+        std::lock_guard<std::mutex> lock{mutex};
+        const ParseResult *const old{current.exchange(fresh.release())};
+        // readers that started before this might still be reading old, and they've all recorded
+        // an epoch of (at most) this one
+        retired.push_back(Retired{old, epoch.fetch_add(1)});
+        reclaim();
+    }
+    // deletes old results that nothing can be reading anymore, without publishing a new one.
+    // publish() already does this, so it's only needed if you want the memory back sooner
+    void collect() {
+        std::lock_guard<std::mutex> lock{mutex};
+        reclaim();
     }
-    T defaultValue() const {
-        return dv;
+    // how many results have been published, which readers can use to notice that something changed
+    [[nodiscard]] uint64_t generation() const {
+        return epoch.load() - 1;
     }
 private:
-    friend class ArgParser;
-    T data, setValue, dv;
-    bool hasDefault_{false};
+    struct Slot;
+public:
+    class Reader;
+    // the result that was current when Reader::read() was called, which stays valid (and keeps
+    // every value the same) until this is destroyed, even if a new one is published meanwhile
+    class View {
+    public:
+        View(const View &) = delete;
+        View &operator=(const View &) = delete;
+        View(View &&other) noexcept : reader{other.reader}, result{other.result} {
+            other.reader = nullptr;
+        }
+        ~View() {
+            if (reader != nullptr) reader->leave();
+        }
+        const ParseResult &operator*() const {
+            return *result;
+        }
+        const ParseResult *operator->() const {
+            return result;
+        }
+    private:
+        friend class Reader;
+        View(Reader &reader, const ParseResult *result) : reader{&reader}, result{result} {
+        }
+        Reader *reader;
+        const ParseResult *result;
+    };
 
-    void parseArg(const char *arg) override {
-        // set data to the default value if no value is given in the command
-        if (arg[0] == '-') {
-            data = setValue;
-            isDefined_ = true;
-            return;
+    // one per reading thread. a Reader can only be used by one thread at a time, but it can have
+    // more than one View at once
+    class Reader {
+    public:
+        explicit Reader(ReloadableResult &values) : values{values}, slot{new Slot} {
+            std::lock_guard<std::mutex> lock{values.mutex};
+            values.slots.push_back(slot);
+        }
+        Reader(const Reader &) = delete;
+        Reader &operator=(const Reader &) = delete;
+        ~Reader() {
+            std::lock_guard<std::mutex> lock{values.mutex};
+            values.slots.erase(std::find(values.slots.begin(), values.slots.end(), slot));
+            delete slot;
         }
 
-        try {
-            data = stringToType<T>(arg);
-        } catch (std::invalid_argument &) { // rethrow the error with a more informative description
-            throw std::invalid_argument("Command-line argument " + shortName + ", " + longName
-                                        + " recieved an invalid value of \"" + arg + "\"\n");
+        View read() {
+            // the epoch has to be recorded before the result is loaded, so that a publish that
+            // doesn't see the recorded epoch is one whose new result this load will see
+            if (views++ == 0) slot->epoch.store(values.epoch.load());
+            return View{*this, values.current.load()};
         }
+    private:
+        friend class View;
+        ReloadableResult &values;
+        Slot *slot;
+        size_t views{0};
 
-        isDefined_ = true;
-        isSet_ = true;
-    }
+        void leave() {
+            if (--views == 0) slot->epoch.store(IDLE, std::memory_order_release);
+        }
+    };
+private:
+    enum : uint64_t { IDLE = 0 };
+    // each reader's slot holds the epoch it started reading in (or IDLE), and is padded out to a
+    // cache line so readers don't slow each other down
+    struct Slot {
+        std::atomic<uint64_t> epoch{IDLE};
+        char padding[64 - sizeof(std::atomic<uint64_t>)];
+    };
+    struct Retired {
+        const ParseResult *result;
+        uint64_t epoch; // the epoch it was replaced in
+    };
 
-    // *attempts* to return the default value as a string.
-    std::string getDefaultAsString() override {
-        return {"=arg(=" + typeToString(setValue) + ")"};
+    std::atomic<const ParseResult *> current;
+    std::atomic<uint64_t> epoch{1};
+    std::mutex mutex; // held by publish, collect, and readers coming and going, never by reads
+    std::vector<Slot *> slots;
+    std::vector<Retired> retired;
+
+    // a result replaced in epoch e can only be read by readers that recorded e or earlier
+    void reclaim() {
+        uint64_t oldest{~uint64_t{0}};
+        for (const Slot *slot : slots) {
+            const uint64_t e{slot->epoch.load()};
+            if (e != IDLE) oldest = std::min(oldest, e);
+        }
+        auto done = std::partition(retired.begin(), retired.end(),
+            [oldest](const Retired &old) { return old.epoch >= oldest; });
+        for (auto it = done; it != retired.end(); ++it) delete it->result;
+        retired.erase(done, retired.end());
     }
 };
 
-// Flag arguments can only be booleans and cannot have a default value. If a flag argument appears
-// in the command, it is equal to true, otherwise, it is equal to false.
-class [[maybe_unused]] FlagArg : public Argument {
-public:
-    FlagArg(const Visibility visibility, const std::string &shortName, const std::string &longName,
-        const std::string &description) :
-        Argument(visibility, shortName, longName, description) {
-        isDefined_ = true;
+// StaticArgParser is an alternative to ArgParser for when every argument is known at compile time.
+// arguments are types instead of objects, their values are stored in a plain tuple, and each token
+// is matched by a chain of comparisons against names (and name lengths) that are all compile-time
+// constants, so nothing is allocated per argument and nothing is dispatched virtually. values are
+// converted with the same stringToType machinery as everything else.
+// arguments are declared with the CMD_ARGS_STATIC_* macros below, which work in C++11. in C++20
+// they can also be written inline, like StaticValue<int, "v", "value1", "a value argument">
+namespace detail {
+struct StaticValueKind {};
+struct StaticImplicitKind {};
+struct StaticFlagKind {};
+
+// everything an argument declaration has apart from its names
+template <typename T, bool HasDefault = false>
+struct StaticValueBase {
+    typedef T ValueType;
+    typedef StaticValueKind Kind;
+    static constexpr bool hasDefault() {
+        return HasDefault;
     }
-    FlagArg(const std::string &shortName, const std::string &longName,
-        const std::string &description) :
-        FlagArg(VISIBLE, shortName, longName, description) {
+    static T defaultValue() {
+        return T{};
     }
-
-    [[nodiscard]] bool value() const {
-        return data;
+};
+template <typename T, bool HasDefault = false>
+struct StaticImplicitBase {
+    typedef T ValueType;
+    typedef StaticImplicitKind Kind;
+    static constexpr bool hasDefault() {
+        return HasDefault;
     }
-private:
-    friend class ArgParser;
-    bool data{false};
-    void parseArg(const char *arg) override {
-        data = true;
-        isSet_ = true;
+    static T defaultValue() {
+        return T{};
     }
-    // flags never have a default value, but this is still required for the help message
-    std::string getDefaultAsString() override {
-        return "";
+};
+struct StaticFlagBase {
+    typedef bool ValueType;
+    typedef StaticFlagKind Kind;
+    static constexpr bool hasDefault() {
+        return false;
+    }
+    static bool defaultValue() {
+        return false;
     }
 };
 
-class ArgParser {
-public:
-    template <typename ArgType, typename... Args>
-    std::shared_ptr<ArgType> add(Args &&... args) {
-        static_assert(std::is_base_of<Argument, ArgType>::value,
-            "Command-line arguments must be of type FlagArg, ImplicitArg, or ValueArg\n");
-        ArgType arg{args...};
-        auto argPtr = std::make_shared<ArgType>(arg);
+template <size_t I, typename... Ts>
+struct NthType;
+template <typename T, typename... Ts>
+struct NthType<0, T, Ts...> {
+    typedef T type;
+};
+template <size_t I, typename T, typename... Ts>
+struct NthType<I, T, Ts...> : NthType<I - 1, Ts...> {
+};
 
-        // ensure the argument has at least one name
-        if (arg.shortName == "" && arg.longName == "") {
-            throw std::invalid_argument("Command-line arguments must have at least one name\n");
-        }
+// there's deliberately no definition for when T isn't in the list, so using an argument with a
+// parser that doesn't have it is a compile error
+template <typename T, typename... Ts>
+struct IndexOf;
+template <typename T, typename... Ts>
+struct IndexOf<T, T, Ts...> : std::integral_constant<size_t, 0> {
+};
+template <typename T, typename U, typename... Ts>
+struct IndexOf<T, U, Ts...> : std::integral_constant<size_t, 1 + IndexOf<T, Ts...>::value> {
+};
 
-        // create one map entry for each of the argument's names
-        if (arg.shortName != "") arguments[arg.shortName] = argPtr;
-        if (arg.longName != "") arguments[arg.longName] = argPtr;
+constexpr size_t constMax() {
+    return 0;
+}
+template <typename... Rest>
+constexpr size_t constMax(size_t first, Rest... rest) {
+    return first > constMax(rest...) ? first : constMax(rest...);
+}
+}
 
-        // add the argument to one of the two vectors based on its visibility (invisible arguments
-        // aren't added to either)
-        if (arg.visibility == VISIBLE) { visibleArgs.push_back(argPtr); }
-        else if (arg.visibility == HIDDEN) hiddenArgs.push_back(argPtr);
+// the names get their dashes added at compile time, just like Argument does at runtime
+#define CMD_ARGS_STATIC_NAMES_(shortName_, longName_, description_)                                \
+    static constexpr const char *shortName() {                                                     \
+        return sizeof(shortName_) > 1 ? "-" shortName_ : "";                                       \
+    }                                                                                              \
+    static constexpr size_t shortLength() {                                                        \
+        return sizeof(shortName_) > 1 ? sizeof(shortName_) : 0;                                    \
+    }                                                                                              \
+    static constexpr const char *longName() {                                                      \
+        return sizeof(longName_) > 1 ? "--" longName_ : "";                                        \
+    }                                                                                              \
+    static constexpr size_t longLength() {                                                         \
+        return sizeof(longName_) > 1 ? sizeof(longName_) + 1 : 0;                                  \
+    }                                                                                              \
+    static constexpr const char *description() {                                                   \
+        return description_;                                                                       \
+    }
 
-        return argPtr;
+// each of these declares a type called name, which is then used as a StaticArgParser parameter.
+// the names have to be string literals
+#define CMD_ARGS_STATIC_VALUE(name, T, shortName, longName, description)                           \
+    struct name : ::CmdArgs::detail::StaticValueBase<T> {                                          \
+        CMD_ARGS_STATIC_NAMES_(shortName, longName, description)                                   \
+    }
+#define CMD_ARGS_STATIC_VALUE_DEFAULT(name, T, shortName, longName, description, defaultValue_)    \
+    struct name : ::CmdArgs::detail::StaticValueBase<T, true> {                                    \
+        CMD_ARGS_STATIC_NAMES_(shortName, longName, description)                                   \
+        static T defaultValue() {                                                                  \
+            return defaultValue_;                                                                  \
+        }                                                                                          \
+    }
+#define CMD_ARGS_STATIC_IMPLICIT(name, T, shortName, longName, description, setValue_)             \
+    struct name : ::CmdArgs::detail::StaticImplicitBase<T> {                                       \
+        CMD_ARGS_STATIC_NAMES_(shortName, longName, description)                                   \
+        static T setValue() {                                                                      \
+            return setValue_;                                                                      \
+        }                                                                                          \
+    }
+#define CMD_ARGS_STATIC_IMPLICIT_DEFAULT(name, T, shortName, longName, description, setValue_,     \
+    defaultValue_)                                                                                 \
+    struct name : ::CmdArgs::detail::StaticImplicitBase<T, true> {                                 \
+        CMD_ARGS_STATIC_NAMES_(shortName, longName, description)                                   \
+        static T setValue() {                                                                      \
+            return setValue_;                                                                      \
+        }                                                                                          \
+        static T defaultValue() {                                                                  \
+            return defaultValue_;                                                                  \
+        }                                                                                          \
+    }
+#define CMD_ARGS_STATIC_FLAG(name, shortName, longName, description)                               \
+    struct name : ::CmdArgs::detail::StaticFlagBase {                                              \
+        CMD_ARGS_STATIC_NAMES_(shortName, longName, description)                                   \
+    }
+
+#if defined(__cpp_nontype_template_args) && __cpp_nontype_template_args >= 201911L
+// a string literal that can be used as a template parameter
+template <size_t N>
+struct FixedString {
+    char chars[N]{};
+    constexpr FixedString() = default;
+    constexpr FixedString(const char (&str)[N]) { // NOLINT(google-explicit-constructor)
+        for (size_t i{0}; i < N; ++i) chars[i] = str[i];
+    }
+    constexpr operator const char *() const { // NOLINT(google-explicit-constructor)
+        return chars;
+    }
+};
+
+namespace detail {
+template <FixedString Short, FixedString Long, FixedString Description>
+struct StaticNames {
+    static constexpr auto shortStorage = [] {
+        FixedString<sizeof(Short.chars) + 1> name{};
+        name.chars[0] = '-';
+        for (size_t i{0}; i < sizeof(Short.chars); ++i) name.chars[i + 1] = Short.chars[i];
+        return name;
+    }();
+    static constexpr auto longStorage = [] {
+        FixedString<sizeof(Long.chars) + 2> name{};
+        name.chars[0] = name.chars[1] = '-';
+        for (size_t i{0}; i < sizeof(Long.chars); ++i) name.chars[i + 2] = Long.chars[i];
+        return name;
+    }();
+    static constexpr const char *shortName() {
+        return sizeof(Short.chars) > 1 ? shortStorage.chars : "";
+    }
+    static constexpr size_t shortLength() {
+        return sizeof(Short.chars) > 1 ? sizeof(Short.chars) : 0;
+    }
+    static constexpr const char *longName() {
+        return sizeof(Long.chars) > 1 ? longStorage.chars : "";
+    }
+    static constexpr size_t longLength() {
+        return sizeof(Long.chars) > 1 ? sizeof(Long.chars) + 1 : 0;
+    }
+    static constexpr const char *description() {
+        return Description.chars;
+    }
+};
+}
+
+// defaults (and set values) are given as template parameters too, so they have to be usable as
+// one. numbers and bools work as they are, and strings work when they're wrapped in a FixedString,
+// like FixedString{"name"} (a bare string literal can't be a template parameter)
+template <typename T, FixedString Short, FixedString Long, FixedString Description = "",
+    auto... Default>
+struct StaticValue : detail::StaticValueBase<T, sizeof...(Default) != 0>,
+                     detail::StaticNames<Short, Long, Description> {
+    static_assert(sizeof...(Default) <= 1, "StaticValue takes at most one default value");
+    static T defaultValue() {
+        return T(Default...);
+    }
+};
+template <typename T, FixedString Short, FixedString Long, FixedString Description, auto SetValue,
+    auto... Default>
+struct StaticImplicit : detail::StaticImplicitBase<T, sizeof...(Default) != 0>,
+                        detail::StaticNames<Short, Long, Description> {
+    static_assert(sizeof...(Default) <= 1, "StaticImplicit takes at most one default value");
+    static T setValue() {
+        return T(SetValue);
+    }
+    static T defaultValue() {
+        return T(Default...);
+    }
+};
+template <FixedString Short, FixedString Long, FixedString Description = "">
+struct StaticFlag : detail::StaticFlagBase, detail::StaticNames<Short, Long, Description> {
+};
+#endif
+
+template <typename... Args>
+class StaticArgParser {
+public:
+    static_assert(sizeof...(Args) > 0, "A StaticArgParser needs at least one argument");
+
+    StaticArgParser() : values{Args::defaultValue()...} {
+        reset();
     }
 
     void parseCmd(int argc, const char **argv) {
-        const char *next;
-        // start at i=1 because the first item in argv is always the path to the executable
-        for (int i{1}; i < argc; ++i) {
-            // i don't actually know if it's possible for an empty string to end up in argv, but
-            // i'm also not going to risk it
-            if (argv[i][0] == '\0' || argv[i] == nullptr) continue;
+        // start after the first item in argv, because it's always the path to the executable
+        parseCmd(argv + (argc > 0 ? 1 : 0), argv + argc);
+    }
+    template <typename Iterator>
+    void parseCmd(Iterator first, Iterator last) {
+        detail::TokenStream<Iterator> tokens{first, last, expandResponseFiles, responseFiles};
+        StringView token, next;
+        bool hasToken{tokens.next(token)};
+        while (hasToken) {
+            const bool hasNext{tokens.next(next)};
+            if (!token.empty()) dispatch<0>(token, hasNext ? next : StringView{}, std::true_type{});
+            token = next;
+            hasToken = hasNext;
+        }
+    }
+    template <typename Tokens>
+    void parseCmd(const Tokens &tokens) {
+        parseCmd(std::begin(tokens), std::end(tokens));
+    }
+    void parseCmd(std::initializer_list<StringView> tokens) {
+        parseCmd(tokens.begin(), tokens.end());
+    }
 
-            if (i < argc - 1) { next = argv[i + 1]; }
-            else { next = ""; }
+    // off by default, like ArgParser's
+    void enableResponseFiles(bool enable = true) {
+        expandResponseFiles = enable;
+    }
 
-            auto argIt = arguments.find(argv[i]);
-            if (argIt != arguments.end()) argIt->second->parseArg(next);
+    // puts every value back to its default
+    void reset() {
+        resetValues(std::integral_constant<size_t, 0>{});
+        for (size_t word{0}; word < wordCount; ++word) {
+            setBits[word] = 0;
+            definedBits[word] = 0;
         }
+        markDefaults(std::integral_constant<size_t, 0>{});
+        responseFiles.clear();
     }
 
-    // creates and returns a formatted help message containing every command
-    std::string createHelpMessage(bool showHidden = false) {
+    template <typename Arg>
+    const typename Arg::ValueType &value() const {
+        return std::get<detail::IndexOf<Arg, Args...>::value>(values);
+    }
+    template <typename Arg>
+    [[nodiscard]] bool isSet() const {
+        return detail::testBit(setBits, detail::IndexOf<Arg, Args...>::value);
+    }
+    template <typename Arg>
+    [[nodiscard]] bool isDefined() const {
+        return detail::testBit(definedBits, detail::IndexOf<Arg, Args...>::value);
+    }
 
-        // find the longest names and the longest default value
-        size_t longestShortName{0};
-        size_t longestLongName{0};
+    // the same format as ArgParser's help messages. the name columns are measured at compile
+    // time, so only the default values have to be rendered here
+    [[nodiscard]] std::string createHelpMessage() const {
+        const std::string defaults[]{defaultAsString<Args>()...};
         size_t longestDefaultValue{0};
-        for (const auto &arg : visibleArgs) {
-            if (arg->shortName.length() > longestShortName) {
-                longestShortName = arg->shortName.length();
-            }
-            if (arg->longName.length() > longestLongName) longestLongName = arg->longName.length();
-            if (arg->getDefaultAsString().length() > longestDefaultValue) {
-                longestDefaultValue = arg->getDefaultAsString().length();
-            }
+        for (const auto &defaultValue : defaults) {
+            longestDefaultValue = std::max(longestDefaultValue, defaultValue.length());
         }
 
-        // also check the longest names and default value with the hidden arguments if they're
-        // enabled
-        if (showHidden) {
-            for (const auto &arg : hiddenArgs) {
-                if (arg->shortName.length() > longestShortName) {
-                    longestShortName = arg->shortName.length();
-                }
-                if (arg->longName.length() > longestLongName) {
-                    longestLongName = arg->longName.length();
-                }
-                if (arg->getDefaultAsString().length() > longestDefaultValue) {
-                    longestDefaultValue = arg->getDefaultAsString().length();
-                }
-            }
+        const char *shortNames[]{Args::shortName()...};
+        const size_t shortLengths[]{Args::shortLength()...};
+        const char *longNames[]{Args::longName()...};
+        const size_t longLengths[]{Args::longLength()...};
+        const char *descriptions[]{Args::description()...};
+
+        std::string helpMessage{"[[Allowed Arguments]]\n"};
+        for (size_t i{0}; i < sizeof...(Args); ++i) {
+            helpMessage.append(2 + longestShortName - shortLengths[i], ' ');
+            helpMessage.append(shortNames[i], shortLengths[i]);
+            helpMessage.append(", ");
+            helpMessage.append(longNames[i], longLengths[i]);
+            helpMessage += ' ';
+            helpMessage += defaults[i];
+            helpMessage.append(
+                longestLongName + longestDefaultValue - longLengths[i] - defaults[i].length() + 2,
+                ' ');
+            helpMessage.append(descriptions[i]);
+            helpMessage += '\n';
         }
+        return helpMessage;
+    }
+private:
+    static constexpr size_t wordCount{(sizeof...(Args) + 63) / 64};
+    static constexpr size_t longestShortName{detail::constMax(Args::shortLength()...)};
+    static constexpr size_t longestLongName{detail::constMax(Args::longLength()...)};
 
-        std::ostringstream helpMessage;
-        helpMessage << "[[Allowed Arguments]]\n";
+    std::tuple<typename Args::ValueType...> values;
+    uint64_t setBits[wordCount];
+    uint64_t definedBits[wordCount];
+    bool expandResponseFiles{false};
+    std::vector<std::unique_ptr<detail::MappedFile>> responseFiles;
 
-        // print the visible arguments
-        for (const auto &arg : visibleArgs) {
-            // the long name and the default value are merged together to make formatting work
-            std::string longNameDefaultValue{arg->longName + " " + arg->getDefaultAsString()};
+    static bool matches(StringView token, const char *name, size_t length) {
+        return length != 0 && token.length() == length
+               && std::memcmp(token.data(), name, length) == 0;
+    }
+    template <typename Arg>
+    static std::string namesForErrors() {
+        return std::string{Arg::shortName()}
+               + (Arg::shortLength() != 0 && Arg::longLength() != 0 ? "/" : "") + Arg::longName();
+    }
 
-            helpMessage << "  " << std::right << std::setw(static_cast<int>(longestShortName))
-                        << arg->shortName << std::setw(0) << ", " << std::left
-                        << std::setw(static_cast<int>(longestLongName + longestDefaultValue + 1))
-                        << longNameDefaultValue << std::setw(0) << "  " << arg->description << '\n';
+    // tries each argument in order. every name and length here is a constant, so the compiler
+    // can fold all of this into a handful of length checks and compares
+    template <size_t I>
+    void dispatch(StringView token, StringView next, std::true_type /* in range */) {
+        typedef typename detail::NthType<I, Args...>::type Arg;
+        if (matches(token, Arg::shortName(), Arg::shortLength())
+            || matches(token, Arg::longName(), Arg::longLength())) {
+            apply<I, Arg>(next, typename Arg::Kind{});
+            return;
         }
+        dispatch<I + 1>(token, next, std::integral_constant<bool, I + 1 < sizeof...(Args)>{});
+    }
+    template <size_t I>
+    void dispatch(StringView, StringView, std::false_type /* in range */) {
+    }
 
-        // print the hidden arguments if they're enabled
-        if (showHidden) {
-            helpMessage << "[[Hidden Arguments]]\n";
-            for (const auto &arg : hiddenArgs) {
-                // the long name and the default value are merged together to make formatting work
-                std::string longNameDefaultValue{arg->longName + " " + arg->getDefaultAsString()};
-
-                helpMessage << "  " << std::right << std::setw(static_cast<int>(longestShortName))
-                            << arg->shortName << std::setw(0) << ", " << std::left
-                            << std::setw(
-                                static_cast<int>(longestLongName + longestDefaultValue + 1))
-                            << longNameDefaultValue << std::setw(0) << "  " << arg->description
-                            << '\n';
-            }
+    // these do the same things as the parseValue methods of ValueArg, ImplicitArg, and FlagArg
+    template <size_t I, typename Arg>
+    void apply(StringView next, detail::StaticValueKind) {
+        if (!next.empty() && next[0] == '-') {
+            throw std::invalid_argument("Command-line argument " + namesForErrors<Arg>()
+                                        + " requires a value but none was given\n");
+        }
+        try {
+            std::get<I>(values) = detail::fromString<typename Arg::ValueType>(next);
+        } catch (std::invalid_argument &) {
+            throw std::invalid_argument("Command-line argument " + namesForErrors<Arg>()
+                                        + " recieved an invalid value of \"" + next.str()
+                                        + "\"\n");
+        }
+        detail::setBit(setBits, I);
+        detail::setBit(definedBits, I);
+    }
+    template <size_t I, typename Arg>
+    void apply(StringView next, detail::StaticImplicitKind) {
+        if (next.empty() || next[0] == '-') {
+            std::get<I>(values) = Arg::setValue();
+            detail::setBit(definedBits, I);
+            return;
         }
+        try {
+            std::get<I>(values) = detail::fromString<typename Arg::ValueType>(next);
+        } catch (std::invalid_argument &) {
+            throw std::invalid_argument("Command-line argument " + namesForErrors<Arg>()
+                                        + " recieved an invalid value of \"" + next.str()
+                                        + "\"\n");
+        }
+        detail::setBit(setBits, I);
+        detail::setBit(definedBits, I);
+    }
+    template <size_t I, typename Arg>
+    void apply(StringView, detail::StaticFlagKind) {
+        std::get<I>(values) = true;
+        detail::setBit(setBits, I);
+    }
 
-        return helpMessage.str();
+    template <size_t I>
+    void resetValues(std::integral_constant<size_t, I>) {
+        typedef typename detail::NthType<I, Args...>::type Arg;
+        std::get<I>(values) = Arg::defaultValue();
+        resetValues(std::integral_constant<size_t, I + 1>{});
+    }
+    void resetValues(std::integral_constant<size_t, sizeof...(Args)>) {
+    }
+    template <size_t I>
+    void markDefaults(std::integral_constant<size_t, I>) {
+        typedef typename detail::NthType<I, Args...>::type Arg;
+        if (Arg::hasDefault() || std::is_same<typename Arg::Kind, detail::StaticFlagKind>::value) {
+            detail::setBit(definedBits, I);
+        }
+        markDefaults(std::integral_constant<size_t, I + 1>{});
+    }
+    void markDefaults(std::integral_constant<size_t, sizeof...(Args)>) {
     }
-private:
-    // arguments are stored as shared pointers so that they can have keys for both their long and
-    // short names
-    std::map<std::string, std::shared_ptr<Argument>> arguments;
 
-    // used to separate argument visibilities in help messages (and to print arguments in order)
-    std::vector<std::shared_ptr<Argument>> visibleArgs;
-    std::vector<std::shared_ptr<Argument>> hiddenArgs;
+    template <typename Arg>
+    static std::string defaultAsString(detail::StaticValueKind) {
+        return Arg::hasDefault() ? "=" + typeToString(Arg::defaultValue()) : "";
+    }
+    template <typename Arg>
+    static std::string defaultAsString(detail::StaticImplicitKind) {
+        return "=arg(=" + typeToString(Arg::setValue()) + ")";
+    }
+    template <typename Arg>
+    static std::string defaultAsString(detail::StaticFlagKind) {
+        return "";
+    }
+    template <typename Arg>
+    static std::string defaultAsString() {
+        return defaultAsString<Arg>(typename Arg::Kind{});
+    }
 };
 }
 
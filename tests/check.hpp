@@ -0,0 +1,114 @@
+// a tiny test harness, so the tests don't need anything but the standard library. each test file
+// is its own executable: TEST(name) { ... } registers a test, CHECK(condition) records a failure
+// without stopping the test, and the main() at the bottom runs every test and returns 1 if
+// anything failed (which is all ctest looks at)
+#ifndef CMD_ARGS_TESTS_CHECK_HPP
+#define CMD_ARGS_TESTS_CHECK_HPP
+
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Check {
+struct Test {
+    const char *name;
+    void (*run)();
+};
+
+inline std::vector<Test> &tests() {
+    static std::vector<Test> registered;
+    return registered;
+}
+
+inline int &failures() {
+    static int count{0};
+    return count;
+}
+
+inline void fail(const char *file, int line, const std::string &what) {
+    std::fprintf(stderr, "%s:%d: %s\n", file, line, what.c_str());
+    ++failures();
+}
+
+struct Register {
+    Register(const char *name, void (*run)()) { tests().push_back({name, run}); }
+};
+
+// returns what() of the exception f throws (or an empty string if it doesn't throw one), so
+// both that something was thrown and what it said can be checked
+template <typename Exception, typename F> std::string thrown(F f, bool &threw) {
+    threw = false;
+    try {
+        f();
+    } catch (const Exception &e) {
+        threw = true;
+        return e.what();
+    }
+    return "";
+}
+
+// a file in the working directory (the build directory, under ctest) that's removed again
+// once the test is done with it
+class TempFile {
+public:
+    TempFile(std::string path, const std::string &contents) : filePath{std::move(path)} {
+        std::ofstream file{filePath, std::ios::binary};
+        file << contents;
+    }
+    ~TempFile() { std::remove(filePath.c_str()); }
+    TempFile(const TempFile &) = delete;
+    TempFile &operator=(const TempFile &) = delete;
+
+    const std::string &path() const { return filePath; }
+
+private:
+    std::string filePath;
+};
+}
+
+#define TEST(name) \
+    static void name(); \
+    static const Check::Register name##Registered{#name, name}; \
+    static void name()
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) Check::fail(__FILE__, __LINE__, "check failed: " #condition); \
+    } while (false)
+
+// checks that statement throws an Exception
+#define CHECK_THROWS(Exception, statement) \
+    do { \
+        bool threw; \
+        Check::thrown<Exception>([&] { statement; }, threw); \
+        if (!threw) Check::fail(__FILE__, __LINE__, "didn't throw " #Exception ": " #statement); \
+    } while (false)
+
+// checks that statement throws an Exception whose message is exactly message
+#define CHECK_THROWS_MESSAGE(Exception, statement, message) \
+    do { \
+        bool threw; \
+        const std::string what{Check::thrown<Exception>([&] { statement; }, threw)}; \
+        if (!threw) Check::fail(__FILE__, __LINE__, "didn't throw " #Exception ": " #statement); \
+        else if (what != (message)) \
+            Check::fail(__FILE__, __LINE__, "wrong message from " #statement ": " + what); \
+    } while (false)
+
+int main() {
+    for (const Check::Test &test : Check::tests()) {
+        const int before{Check::failures()};
+        try {
+            test.run();
+        } catch (const std::exception &e) {
+            Check::fail(test.name, 0, std::string{"threw "} + e.what());
+        }
+        std::printf("%s %s\n", Check::failures() == before ? "passed" : "FAILED", test.name);
+    }
+    if (Check::failures() != 0) std::printf("%d checks failed\n", Check::failures());
+    return Check::failures() == 0 ? 0 : 1;
+}
+
+#endif
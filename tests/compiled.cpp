@@ -0,0 +1,49 @@
+// tests for compiled mode: this links the cmd-args library, so the argument types for the common
+// value types come from src/cmd-args.cpp instead of being compiled here
+#include "check.hpp"
+#include "cmd-args.hpp"
+using namespace CmdArgs;
+
+static_assert(CMD_ARGS_COMPILED, "compiled.cpp has to be built with the cmd-args library");
+
+struct Point {
+    int x, y;
+};
+
+template <> Point CmdArgs::stringToType<Point>(const std::string &str) {
+    const size_t comma{str.find(',')};
+    if (comma == std::string::npos) throw std::invalid_argument("not a point\n");
+    return Point{stringToType<int>(str.substr(0, comma)), stringToType<int>(str.substr(comma + 1))};
+}
+
+template <> std::string CmdArgs::typeToString<Point>(const Point point) {
+    return std::to_string(point.x) + "," + std::to_string(point.y);
+}
+
+TEST(compiledTypes) {
+    ArgParser parser;
+    auto flag = parser.add<FlagArg>("f", "flag", "d");
+    auto number = parser.add<ValueArg<int>>("n", "number", "d");
+    auto count = parser.add<ValueArg<unsigned long>>("c", "count", "d", 1ul);
+    auto ratio = parser.add<ImplicitArg<double>>("r", "ratio", "d", 0.5);
+    auto name = parser.add<ValueArg<std::string>>("", "name", "d");
+    auto view = parser.add<ValueArg<StringView>>("", "view", "d");
+    auto ids = parser.add<ListArg<long long>>("i", "ids", "d");
+    parser.parseCmd({"-f", "--number=-3", "-r", "--name", "x", "--view", "y", "-i", "1,2"});
+    CHECK(flag->value() && number->value() == -3 && count->value() == 1ul);
+    CHECK(ratio->value() == 0.5 && name->value() == "x" && view->value() == "y");
+    CHECK((ids->value() == std::vector<long long>{1, 2}));
+    parser.reset();
+    CHECK_THROWS(std::invalid_argument, parser.parseCmd({"--count=-1"}));
+}
+
+// types that aren't compiled into the library still work
+TEST(otherTypes) {
+    ArgParser parser;
+    auto origin = parser.add<ValueArg<Point>>("o", "origin", "d");
+    auto small = parser.add<ValueArg<short>>("s", "small", "d");
+    parser.parseCmd({"-o", "3,4", "-s", "7"});
+    CHECK(origin->value().x == 3 && origin->value().y == 4 && small->value() == 7);
+    parser.reset();
+    CHECK_THROWS(std::invalid_argument, parser.parseCmd({"-o", "3"}));
+}
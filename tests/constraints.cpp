@@ -0,0 +1,201 @@
+// tests for the rules a parser checks about which arguments a command uses
+#include <cstdlib>
+#include "check.hpp"
+#include "cmd-args.hpp"
+using namespace CmdArgs;
+
+// the arguments and rules from the README
+struct Rules {
+    ArgParser parser;
+    std::shared_ptr<ValueArg<std::string>> input;
+    std::shared_ptr<FlagArg> useStdin;
+    std::shared_ptr<ValueArg<std::string>> key;
+    std::shared_ptr<ValueArg<std::string>> cert;
+    std::shared_ptr<FlagArg> quiet;
+    std::shared_ptr<FlagArg> loud;
+    std::shared_ptr<ValueArg<int>> jobs;
+    std::shared_ptr<ValueArg<double>> ratio;
+    std::shared_ptr<ValueArg<std::string>> name;
+
+    Rules() {
+        input = parser.add<ValueArg<std::string>>("i", "input", "d");
+        useStdin = parser.add<FlagArg>("", "stdin", "d");
+        key = parser.add<ValueArg<std::string>>("", "tls-key", "d");
+        cert = parser.add<ValueArg<std::string>>("", "tls-cert", "d");
+        quiet = parser.add<FlagArg>("q", "quiet", "d");
+        loud = parser.add<FlagArg>("l", "loud", "d");
+        jobs = parser.add<ValueArg<int>>("j", "jobs", "d", 4);
+        ratio = parser.add<ValueArg<double>>("r", "ratio", "d");
+        name = parser.add<ValueArg<std::string>>("n", "name", "d");
+        parser.exactlyOne({input, useStdin});
+        parser.dependsOn(key, cert);
+        parser.conflicts(quiet, loud);
+        parser.range(jobs, 1, 64);
+        parser.range(ratio, 0.0, 1.0);
+        parser.require(name);
+    }
+
+    // the kind of the first rule the command breaks, or -1 if it doesn't break any
+    int firstBroken(std::initializer_list<StringView> command) {
+        parser.reset();
+        const ParseStatus status{parser.tryParseCmd(command)};
+        return status ? -1 : status.errors()[0].kind;
+    }
+};
+
+TEST(eachRule) {
+    Rules rules;
+    CHECK(rules.firstBroken({"--stdin", "-n", "x"}) == -1);
+    CHECK(rules.firstBroken({"-n", "x"}) == ParseError::MISSING_ONE_OF);
+    CHECK(rules.firstBroken({"--stdin", "-i", "f", "-n", "x"}) == ParseError::MUTUALLY_EXCLUSIVE);
+    CHECK(rules.firstBroken({"--stdin", "--tls-key", "k", "-n", "x"})
+        == ParseError::MISSING_DEPENDENCY);
+    CHECK(rules.firstBroken({"--stdin", "--tls-key", "k", "--tls-cert", "c", "-n", "x"}) == -1);
+    CHECK(rules.firstBroken({"--stdin", "-q", "-l", "-n", "x"}) == ParseError::CONFLICTING);
+    CHECK(rules.firstBroken({"--stdin", "-j", "100", "-n", "x"}) == ParseError::OUT_OF_RANGE);
+    CHECK(rules.firstBroken({"--stdin", "-r", "1.5", "-n", "x"}) == ParseError::OUT_OF_RANGE);
+    CHECK(rules.firstBroken({"--stdin", "-r", "1", "-j", "64", "-n", "x"}) == -1);
+    CHECK(rules.firstBroken({"--stdin"}) == ParseError::MISSING_REQUIRED);
+}
+
+TEST(everyBrokenRule) {
+    Rules rules;
+    const ParseStatus status{rules.parser.tryParseCmd({"-i", "f", "--stdin", "--tls-key", "k",
+        "-q", "-l", "-j", "0"})};
+    CHECK(status.errors().size() == 5);
+    CHECK(status.errors()[0].kind == ParseError::MUTUALLY_EXCLUSIVE);
+    CHECK(status.errors()[0].argument == 1 && status.errors()[0].constraint == 0);
+    CHECK(status.errors()[1].kind == ParseError::MISSING_DEPENDENCY);
+    CHECK(status.errors()[1].argument == 2);
+    CHECK(status.errors()[4].kind == ParseError::MISSING_REQUIRED);
+    CHECK(status.errors()[4].argument == 8);
+    for (const ParseError &error : status.errors()) CHECK(error.token == ParseError::npos);
+    // parseCmd throws for the first one
+    rules.parser.reset();
+    CHECK_THROWS_MESSAGE(std::invalid_argument, rules.parser.parseCmd({"-i", "f", "--stdin",
+        "--tls-key", "k", "-q", "-l", "-j", "0"}), rules.parser.errorMessage(status.errors()[0]));
+}
+
+TEST(parseChecksRules) {
+    Rules rules;
+    rules.parser.freeze();
+    CHECK_THROWS(std::invalid_argument, (void)rules.parser.parse({"--stdin"}));
+    const ParseResult result{rules.parser.parse({"--stdin", "-n", "a"})};
+    CHECK(result.isSet(rules.useStdin));
+}
+
+TEST(rangesAndTheEnvironment) {
+    Rules rules;
+    rules.parser.setEnvPrefix("CONSTRAINTS_");
+    rules.parser.bindEnv(rules.jobs);
+    setenv("CONSTRAINTS_JOBS", "99", 1);
+    CHECK(rules.firstBroken({"--stdin", "-n", "x"}) == ParseError::OUT_OF_RANGE);
+    unsetenv("CONSTRAINTS_JOBS");
+}
+
+TEST(countingDefinedArguments) {
+    const Check::TempFile file{"constraints-defined.conf", "token = abc\nuser = admin\n"};
+    ArgParser parser;
+    auto token = parser.add<ValueArg<std::string>>("t", "token", "d");
+    auto user = parser.add<ValueArg<std::string>>("u", "user", "d");
+    auto port = parser.add<ValueArg<int>>("p", "port", "d", 80);
+    auto socket = parser.add<ValueArg<std::string>>("s", "socket", "d");
+    auto level = parser.add<ImplicitArg<int>>("l", "level", "d", 3);
+    auto verbose = parser.add<FlagArg>("v", "verbose", "d");
+    parser.setEnvPrefix("CONSTRAINTS_");
+    parser.bindEnv(token);
+    parser.bindEnv(port);
+    parser.require(token, COUNT_DEFINED);
+    parser.require(user);
+    parser.conflicts(port, socket, COUNT_DEFINED);
+    parser.dependsOn(verbose, level, COUNT_DEFINED);
+    setenv("CONSTRAINTS_TOKEN", "secret", 1);
+    // a token from the environment satisfies require(token, COUNT_DEFINED), but require(user)
+    // still wants one in the command
+    ParseStatus status{parser.tryParseCmd({})};
+    CHECK(status.errors().size() == 1 && status.errors()[0].kind == ParseError::MISSING_REQUIRED);
+    CHECK(status.errors()[0].argument == 1 && token->value() == "secret");
+    parser.reset();
+    CHECK(parser.tryParseCmd({"-u", "x"}).ok());
+    parser.reset();
+    unsetenv("CONSTRAINTS_TOKEN");
+    status = parser.tryParseCmd({"-u", "x"});
+    CHECK(status.errors().size() == 1 && status.errors()[0].argument == 0);
+    parser.reset();
+    // a config file read before the command counts, but only for COUNT_DEFINED
+    parser.parseConfigFile(file.path());
+    status = parser.tryParseCmd({});
+    CHECK(status.errors().size() == 1 && status.errors()[0].argument == 1);
+    parser.reset();
+    // a default doesn't count, but the environment does, even for an argument with one
+    CHECK(parser.tryParseCmd({"-t", "x", "-u", "x", "-s", "/tmp/s"}).ok());
+    parser.reset();
+    setenv("CONSTRAINTS_PORT", "8080", 1);
+    status = parser.tryParseCmd({"-t", "x", "-u", "x", "-s", "/tmp/s"});
+    CHECK(status.errors().size() == 1 && status.errors()[0].kind == ParseError::CONFLICTING);
+    unsetenv("CONSTRAINTS_PORT");
+    parser.reset();
+    // an implicit argument named without a value is defined, which is enough here
+    CHECK(!parser.tryParseCmd({"-t", "x", "-u", "x", "-v"}).ok());
+    parser.reset();
+    CHECK(parser.tryParseCmd({"-t", "x", "-u", "x", "-v", "-l"}).ok());
+    // parse() checks them the same way
+    setenv("CONSTRAINTS_TOKEN", "secret", 1);
+    parser.freeze();
+    CHECK(parser.parse({"-u", "x"}).value(token) == "secret");
+    unsetenv("CONSTRAINTS_TOKEN");
+    CHECK_THROWS(std::invalid_argument, (void)parser.parse({"-u", "x"}));
+}
+
+TEST(rulesWithLazyConversion) {
+    Rules rules;
+    rules.parser.enableLazyConversion();
+    CHECK(rules.firstBroken({"--stdin", "-n", "x", "-j", "65"}) == ParseError::OUT_OF_RANGE);
+    CHECK(rules.firstBroken({"--stdin", "-n", "x", "-j", "zz"}) == ParseError::INVALID_VALUE);
+    CHECK(rules.firstBroken({"--stdin", "-n", "x", "-j", "5"}) == -1 && rules.jobs->value() == 5);
+}
+
+TEST(configFileRanges) {
+    const Check::TempFile outside{"constraints-outside.conf", "jobs = 100\n"};
+    const Check::TempFile inside{"constraints-inside.conf", "jobs = 8\n"};
+    ArgParser parser;
+    auto jobs = parser.add<ValueArg<int>>("j", "jobs", "d", 4);
+    parser.range(jobs, 1, 64);
+    parser.range(jobs, 0, 200);
+    parser.parseCmd({});
+    CHECK_THROWS(std::invalid_argument, parser.parseConfigFile(outside.path()));
+    parser.reset();
+    parser.parseConfigFile(inside.path());
+    CHECK(jobs->value() == 8);
+    parser.freeze();
+    ParseResult result{parser.parse({})};
+    CHECK_THROWS(std::invalid_argument, parser.parseConfigFile(result, outside.path()));
+}
+
+TEST(invalidRules) {
+    Rules rules;
+    ArgParser other;
+    auto foreign = other.add<FlagArg>("f", "foreign", "d");
+    CHECK_THROWS(std::invalid_argument, rules.parser.require(foreign));
+    CHECK_THROWS(std::invalid_argument, rules.parser.range(rules.jobs, 10, 1));
+    // the default has to be in range too
+    CHECK_THROWS(std::invalid_argument, rules.parser.range(rules.jobs, 10, 20));
+    CHECK_THROWS_MESSAGE(std::invalid_argument, rules.parser.atLeastOne({}),
+        "Constraints can't have an empty group\n");
+}
+
+TEST(manyRules) {
+    ArgParser parser{ARENA_STORAGE};
+    std::vector<std::shared_ptr<FlagArg>> flags;
+    for (int i = 0; i < 3000; ++i)
+        flags.push_back(parser.add<FlagArg>("", "f" + std::to_string(i), "d"));
+    for (int i = 0; i + 10 < 3000; i += 10) {
+        parser.mutuallyExclusive({flags[i], flags[i + 1], flags[i + 5]});
+        parser.dependsOn(flags[i + 2], flags[i + 3]);
+        parser.conflicts(flags[i + 7], flags[i + 9]);
+    }
+    parser.parseCmd({"--f0", "--f2", "--f3", "--f1500"});
+    parser.reset();
+    const ParseStatus status{parser.tryParseCmd({"--f2980", "--f2982", "--f2987", "--f2989"})};
+    CHECK(status.errors().size() == 2);
+}
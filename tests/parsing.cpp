@@ -0,0 +1,266 @@
+// tests for parsing commands
+#include "check.hpp"
+#include "cmd-args.hpp"
+using namespace CmdArgs;
+
+TEST(valuesFlagsAndImplicits) {
+    ArgParser parser;
+    auto value = parser.add<ValueArg<int>>("v", "value", "a value");
+    auto fallback = parser.add<ValueArg<int>>("", "fallback", "a value with a default", 42);
+    auto implicit = parser.add<ImplicitArg<int>>("i", "implicit", "an implicit value", 37);
+    auto implicitDefault = parser.add<ImplicitArg<int>>("", "other", "d", 438, 19);
+    auto flag = parser.add<FlagArg>("f", "flag", "a flag");
+    auto unused = parser.add<FlagArg>("", "unused", "another flag");
+    const char *argv[]{"prog", "-v", "53", "-i", "--flag"};
+    parser.parseCmd(5, argv);
+    CHECK(value->value() == 53 && value->isSet() && value->isDefined());
+    CHECK(fallback->value() == 42 && !fallback->isSet() && fallback->isDefined());
+    // an implicit argument named without a value is defined, but not set
+    CHECK(implicit->value() == 37 && !implicit->isSet() && implicit->isDefined());
+    CHECK(implicitDefault->value() == 19 && implicitDefault->defaultSetValue() == 438);
+    CHECK(flag->value() && !unused->value());
+}
+
+TEST(missingAndInvalidValues) {
+    ArgParser parser;
+    auto value = parser.add<ValueArg<int>>("v", "value", "a value");
+    parser.add<FlagArg>("f", "flag", "a flag");
+    CHECK_THROWS(std::invalid_argument, parser.parseCmd({"-v"}));
+    parser.reset();
+    CHECK_THROWS(std::invalid_argument, parser.parseCmd({"-v", "-f"}));
+    parser.reset();
+    CHECK_THROWS(std::invalid_argument, parser.parseCmd({"-v", "abc"}));
+    CHECK(!value->isSet());
+}
+
+TEST(freezing) {
+    ArgParser parser;
+    auto first = parser.add<FlagArg>("a", "first", "d");
+    CHECK(!parser.isFrozen());
+    parser.freeze();
+    CHECK(parser.isFrozen());
+    // adding another argument unfreezes the parser, and parseCmd freezes it again
+    auto second = parser.add<FlagArg>("b", "second", "d");
+    CHECK(!parser.isFrozen());
+    parser.parseCmd({"--second", "-a"});
+    CHECK(parser.isFrozen() && first->value() && second->value());
+}
+
+TEST(manyArguments) {
+    ArgParser parser;
+    std::vector<std::shared_ptr<ValueArg<int>>> options;
+    for (int i = 0; i < 1500; ++i)
+        options.push_back(parser.add<ValueArg<int>>("", "option-" + std::to_string(i), "d", i));
+    const std::string name{"--option-1234"};
+    parser.parseCmd({StringView{name}, "7", "--option-0", "1"});
+    CHECK(options[1234]->value() == 7 && options[0]->value() == 1);
+    CHECK(options[1499]->value() == 1499);
+}
+
+TEST(tokensWithoutTerminators) {
+    ArgParser parser;
+    auto flag = parser.add<FlagArg>("f", "flag", "d");
+    auto value = parser.add<ValueArg<int>>("", "long-option-name", "d");
+    // tokens are compared by length, so they don't have to end where the name does
+    const std::string buffer{"--flagXYZ--long-option-name42"};
+    const char *data{buffer.data()};
+    parser.parseCmd({StringView{data, 6}, StringView{data + 9, 18}, StringView{data + 27, 2}});
+    CHECK(flag->value() && value->value() == 42);
+}
+
+TEST(tokenSources) {
+    ArgParser parser;
+    auto value = parser.add<ValueArg<int>>("v", "value", "d", 5);
+    auto flag = parser.add<FlagArg>("f", "flag", "d");
+    const std::vector<StringView> views{"-v", "9", "--flag"};
+    parser.parseCmd(views);
+    CHECK(value->value() == 9 && flag->value());
+    parser.reset();
+    const std::vector<std::string> strings{"-v", "10"};
+    parser.parseCmd(strings.begin(), strings.end());
+    CHECK(value->value() == 10 && !flag->value());
+}
+
+TEST(reset) {
+    ArgParser parser;
+    auto value = parser.add<ValueArg<int>>("v", "value", "d", 5);
+    auto text = parser.add<ValueArg<std::string>>("s", "str", "d", std::string{"default"});
+    auto list = parser.add<ListArg<int>>("l", "list", "d", std::vector<int>{1});
+    auto flag = parser.add<FlagArg>("f", "flag", "d");
+    const std::string longText(100, 'x');
+    parser.parseCmd({"-v", "7", "-s", StringView{longText}, "-l", "2,3", "-f"});
+    CHECK(value->value() == 7 && text->value() == longText && list->value().size() == 2);
+    parser.reset();
+    CHECK(value->value() == 5 && !value->isSet() && value->isDefined());
+    CHECK(text->value() == "default" && text->value().capacity() >= longText.size());
+    CHECK(list->value() == std::vector<int>{1} && !flag->value() && !list->isSet());
+}
+
+TEST(abbreviations) {
+    ArgParser parser;
+    auto verbose = parser.add<FlagArg>("v", "verbose", "d");
+    auto version = parser.add<FlagArg>("", "version", "d");
+    auto threads = parser.add<ValueArg<int>>("t", "threads", "d");
+    // they're off by default
+    parser.parseCmd({"--thr", "3"});
+    CHECK(!threads->isSet());
+    parser.reset();
+    parser.enableAbbreviations();
+    parser.parseCmd({"--verb", "--thr", "3"});
+    CHECK(verbose->value() && !version->value() && threads->value() == 3);
+    parser.reset();
+    CHECK_THROWS(std::invalid_argument, parser.parseCmd({"--ver"}));
+}
+
+TEST(suggestions) {
+    ArgParser parser;
+    parser.add<FlagArg>("v", "verbose", "d");
+    parser.add<FlagArg>("", "version", "d");
+    parser.add<ValueArg<int>>("t", "threads", "d");
+    CHECK_THROWS(std::logic_error, (void)parser.suggest("--verbsoe"));
+    parser.freeze();
+    const std::vector<std::string> close{parser.suggest("--verbsoe")};
+    CHECK(!close.empty() && close[0] == "--verbose");
+    CHECK(parser.suggest("--completely-different").empty());
+    CHECK(parser.suggest("--thread", 1) == std::vector<std::string>{"--threads"});
+}
+
+TEST(attachedValues) {
+    ArgParser parser;
+    auto offset = parser.add<ValueArg<int>>("o", "offset", "d");
+    auto verbose = parser.add<FlagArg>("v", "verbose", "d");
+    auto level = parser.add<ImplicitArg<int>>("l", "level", "d", 3, 1);
+    parser.parseCmd({"--offset=-5", "--verbose=false", "--level="});
+    CHECK(offset->value() == -5 && !verbose->value() && verbose->isSet() && level->value() == 3);
+    parser.reset();
+    CHECK_THROWS(std::invalid_argument, parser.parseCmd({"--verbose=maybe"}));
+}
+
+TEST(flagClusters) {
+    ArgParser parser;
+    auto x = parser.add<FlagArg>("x", "", "d");
+    auto v = parser.add<FlagArg>("v", "", "d");
+    auto jobs = parser.add<ValueArg<int>>("j", "jobs", "d");
+    auto exact = parser.add<FlagArg>("xv", "", "d");
+    parser.parseCmd({"-vj8"});
+    CHECK(v->value() && jobs->value() == 8 && !x->value());
+    parser.reset();
+    parser.parseCmd({"-xvj", "3"});
+    CHECK(x->value() && v->value() && jobs->value() == 3);
+    parser.reset();
+    // exact names win over clusters
+    parser.parseCmd({"-xv"});
+    CHECK(exact->value() && !x->value() && !v->value());
+    parser.reset();
+    // a cluster with a name that doesn't exist is left alone
+    parser.parseCmd({"-xq"});
+    CHECK(!x->value() && parser.rest().size() == 1 && parser.rest()[0] == "-xq");
+}
+
+TEST(tryParseCmd) {
+    ArgParser parser;
+    auto verbose = parser.add<FlagArg>("v", "verbose", "d");
+    auto jobs = parser.add<ValueArg<int>>("j", "jobs", "d", 1);
+    parser.add<ValueArg<int>>("o", "offset", "d", 0);
+    parser.add<ListArg<int>>("i", "ids", "d");
+    parser.add<FlagArg>("", "version", "d");
+    parser.enableAbbreviations();
+    const char *argv[]{"prog", "-j", "abc", "--offset", "-v", "--ids=1,x,3", "--ver", "-j7"};
+    const ParseStatus status{parser.tryParseCmd(8, argv)};
+    CHECK(!status && status.errors().size() == 4);
+    CHECK(status.errors()[0].kind == ParseError::INVALID_VALUE && status.errors()[0].argument == 1);
+    CHECK(status.errors()[0].token == 0 && status.errors()[0].value == "abc");
+    CHECK(status.errors()[1].kind == ParseError::MISSING_VALUE);
+    CHECK(status.errors()[2].kind == ParseError::INVALID_ELEMENT);
+    CHECK(status.errors()[2].value == "x");
+    CHECK(status.errors()[3].kind == ParseError::AMBIGUOUS_NAME);
+    // parsing carries on after each error
+    CHECK(jobs->value() == 7 && verbose->value());
+    const std::string first{parser.errorMessage(status.errors()[0])};
+    CHECK(parser.errorMessages(status).compare(0, first.size(), first) == 0);
+    // the messages are the ones parseCmd throws
+    parser.reset();
+    CHECK_THROWS_MESSAGE(std::invalid_argument, parser.parseCmd(8, argv), first);
+    parser.reset();
+    const ParseStatus fine{parser.tryParseCmd({"-vj", "3"})};
+    CHECK(fine.ok() && fine.errors().capacity() == 0 && jobs->value() == 3);
+}
+
+TEST(subcommands) {
+    ArgParser parser;
+    auto verbose = parser.add<FlagArg>("v", "verbose", "d");
+    auto dir = parser.add<ValueArg<std::string>>("C", "dir", "d", std::string{"."});
+    int built{0};
+    std::shared_ptr<ValueArg<int>> jobs;
+    parser.addSubcommand("build", "compiles everything", [&](ArgParser &build) {
+        ++built;
+        jobs = build.add<ValueArg<int>>("j", "jobs", "d", 1);
+    });
+    parser.addSubcommand("test", "runs the tests", [&](ArgParser &) { ++built; });
+    CHECK(parser.createHelpMessage().find("compiles everything") != std::string::npos);
+    CHECK(built == 0);
+    // a subcommand's name that's the value of the argument before it isn't a subcommand
+    parser.parseCmd({"-v", "-C", "build", "build", "-j8", "-v"});
+    CHECK(built == 1 && parser.subcommand() == "build" && dir->value() == "build");
+    CHECK(verbose->value() && jobs->value() == 8);
+    CHECK(parser.subcommandParser("build").rest().size() == 1);
+    parser.reset();
+    CHECK(parser.subcommand().empty() && jobs->value() == 1);
+    const ParseStatus status{parser.tryParseCmd({"build", "-j", "x"})};
+    CHECK(status.errors().size() == 1 && built == 1);
+    parser.reset();
+    parser.parseCmd({"test", "-v"});
+    CHECK(built == 2 && parser.subcommand() == "test" && !verbose->value());
+    // parse() stops at the subcommand's name
+    const ParseResult result{parser.parse({"-v", "build", "-j", "3"})};
+    CHECK(result.subcommand() == "build" && result.value(verbose));
+    CHECK_THROWS(std::invalid_argument, parser.subcommandParser("nope"));
+    CHECK_THROWS(std::invalid_argument, parser.addSubcommand("-x", "d", [](ArgParser &) {}));
+}
+
+TEST(positionals) {
+    ArgParser parser;
+    auto verbose = parser.add<FlagArg>("v", "verbose", "d");
+    auto count = parser.add<ValueArg<int>>("n", "num", "d", 3);
+    auto input = parser.addPositional<ValueArg<std::string>>("input", "the input file");
+    auto output = parser.addPositional<ValueArg<std::string>>("output", "the output file", "a.out");
+    const char *argv[]{"prog", "-v", "in.txt", "-n", "5", "out.txt", "extra", "--", "-x", "@x"};
+    parser.parseCmd(10, argv);
+    CHECK(verbose->value() && count->value() == 5);
+    CHECK(input->value() == "in.txt" && output->value() == "out.txt");
+    CHECK(parser.rest().size() == 3 && parser.rest().strings() == nullptr);
+    CHECK(parser.rest()[0] == "extra" && parser.rest()[1] == "-x" && parser.rest()[2] == "@x");
+    CHECK(parser.createHelpMessage().find("<input>") != std::string::npos);
+    parser.reset();
+    // after --, tokens only fill positionals, and the rest of argv is used as it is
+    const char *dashes[]{"prog", "--", "-in", "-out", "a", "b"};
+    parser.parseCmd(6, dashes);
+    CHECK(input->value() == "-in" && output->value() == "-out");
+    CHECK(parser.rest().strings() == dashes + 4 && parser.rest().size() == 2);
+    parser.reset();
+    parser.parseCmd({"-"});
+    CHECK(input->value() == "-" && output->value() == "a.out" && !output->isSet());
+    CHECK_THROWS(std::invalid_argument, parser.addPositional<ValueArg<int>>("", "d"));
+}
+
+TEST(positionalErrors) {
+    ArgParser parser;
+    parser.addPositional<ValueArg<int>>("count", "how many");
+    CHECK_THROWS(std::invalid_argument, parser.parseCmd({"abc"}));
+    parser.reset();
+    const ParseStatus status{parser.tryParseCmd({"--", "zz"})};
+    CHECK(!status.ok());
+    CHECK(parser.errorMessage(status.errors()[0]).find("<count>") != std::string::npos);
+}
+
+TEST(unmatchedDashTokens) {
+    ArgParser parser;
+    auto verbose = parser.add<FlagArg>("v", "v", "d");
+    auto number = parser.addPositional<ValueArg<int>>("n", "d");
+    auto ratio = parser.addPositional<ValueArg<double>>("x", "d");
+    parser.parseCmd({"-5", "--nope=3", "-v", "-.25", "-q", "-7"});
+    CHECK(number->value() == -5 && ratio->value() == -0.25 && verbose->value());
+    std::vector<std::string> rest;
+    for (StringView token : parser.rest()) rest.push_back(token.str());
+    CHECK((rest == std::vector<std::string>{"--nope=3", "-q", "-7"}));
+}
@@ -0,0 +1,275 @@
+// tests for keeping a parse's results somewhere other than the arguments
+#include <atomic>
+#include <thread>
+#include "check.hpp"
+#include "cmd-args.hpp"
+using namespace CmdArgs;
+
+enum class Codec { LZ4, ZSTD, NONE };
+
+// the same arguments, for a parser that takes a snapshot and one that loads it
+struct Schema {
+    ArgParser parser;
+    std::shared_ptr<ValueArg<int>> number;
+    std::shared_ptr<ValueArg<double>> ratio;
+    std::shared_ptr<ValueArg<std::string>> text;
+    std::shared_ptr<ValueArg<StringView>> view;
+    std::shared_ptr<ImplicitArg<long long>> implicit;
+    std::shared_ptr<FlagArg> flag;
+    std::shared_ptr<ValueArg<bool>> toggle;
+    std::shared_ptr<ListArg<std::string>> list;
+    std::shared_ptr<ChoiceArg<Codec>> codec;
+    std::shared_ptr<ChoiceArg<Codec>> fallback;
+    std::shared_ptr<ValueArg<unsigned>> count;
+    std::shared_ptr<FlagArg> subcommandFlag;
+
+    Schema() {
+        number = parser.add<ValueArg<int>>("n", "number", "d");
+        ratio = parser.add<ValueArg<double>>("r", "ratio", "d", 0.5);
+        text = parser.add<ValueArg<std::string>>("s", "text", "d");
+        view = parser.add<ValueArg<StringView>>("", "view", "d");
+        implicit = parser.add<ImplicitArg<long long>>("i", "implicit", "d", 7);
+        flag = parser.add<FlagArg>("f", "flag", "d");
+        toggle = parser.add<ValueArg<bool>>("t", "toggle", "d");
+        list = parser.add<ListArg<std::string>>("l", "list", "d");
+        codec = parser.add<ChoiceArg<Codec>>("c", "codec", "d",
+            ChoiceArg<Codec>::Choices{{"lz4", Codec::LZ4}, {"zstd", Codec::ZSTD}});
+        fallback = parser.add<ChoiceArg<Codec>>("", "fallback", "d",
+            ChoiceArg<Codec>::Choices{{"lz4", Codec::LZ4}, {"none", Codec::NONE}}, Codec::NONE);
+        count = parser.add<ValueArg<unsigned>>("u", "", "d", 3u);
+        parser.addSubcommand("run", "d", [this](ArgParser &run) {
+            subcommandFlag = run.add<FlagArg>("x", "", "d");
+        });
+    }
+};
+
+TEST(parseResults) {
+    ArgParser parser;
+    auto value = parser.add<ValueArg<int>>("v", "value", "d", 5);
+    auto flag = parser.add<FlagArg>("f", "flag", "d");
+    auto list = parser.add<ListArg<int>>("l", "list", "d", std::vector<int>{1});
+    CHECK_THROWS_MESSAGE(std::logic_error, (void)parser.parse({"-v", "1"}),
+        "ArgParser::parse() requires the parser to be frozen first\n");
+    parser.freeze();
+    ParseResult result{parser.parse({"-v", "9", "--flag", "-l", "2"})};
+    CHECK(result.value(value) == 9 && result.isSet(value) && result.isSet(flag));
+    CHECK((result.value(list) == std::vector<int>{2}) && result.isSet(list));
+    // the parser itself isn't modified
+    CHECK(value->value() == 5 && !value->isSet() && !flag->value());
+    const std::vector<std::string> strings{"-v", "10"};
+    parser.parse(result, strings.begin(), strings.end());
+    CHECK(result.value(value) == 10 && !result.isSet(flag) && result.isDefined(list));
+    const char *argv[]{"prog", "-v", "3"};
+    CHECK(parser.parse(3, argv).value(value) == 3);
+    CHECK_THROWS(std::invalid_argument, (void)parser.parse({"-v", "x"}));
+    // arguments from other parsers aren't in the result
+    ArgParser other;
+    auto foreign = other.add<FlagArg>("a", "b", "c");
+    CHECK_THROWS(std::exception, (void)result.value(foreign));
+}
+
+TEST(parsingOnManyThreads) {
+    ArgParser parser{ARENA_STORAGE};
+    auto value = parser.add<ValueArg<int>>("v", "value", "d", 5);
+    auto text = parser.add<ValueArg<std::string>>("s", "str", "d");
+    auto list = parser.add<ListArg<int>>("l", "list", "d", std::vector<int>{1});
+    auto flag = parser.add<FlagArg>("f", "flag", "d");
+    parser.freeze();
+    std::atomic<int> wrong{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t] {
+            for (int k = 0; k < 500; ++k) {
+                const std::string number{std::to_string(t * 100000 + k)}, str(40, 'a' + t);
+                const char *argv[]{"prog", "-v", number.c_str(), "--str", str.c_str(), "-l", "4,5",
+                    "-l", number.c_str(), k % 2 ? "-f" : "-q"};
+                const ParseResult result{parser.parse(10, argv)};
+                if (result.value(value) != t * 100000 + k || result.value(text) != str
+                    || result.value(list).size() != 3 || result.isSet(flag) != (k % 2 == 1))
+                    ++wrong;
+            }
+        });
+    }
+    for (std::thread &thread : threads) thread.join();
+    CHECK(wrong == 0 && !value->isSet());
+}
+
+TEST(completionIndexes) {
+    ArgParser parser;
+    parser.add<ChoiceArg<Codec>>("c", "codec", "d",
+        ChoiceArg<Codec>::Choices{{"lz4", Codec::LZ4}, {"zstd", Codec::ZSTD},
+            {"none", Codec::NONE}});
+    parser.add<FlagArg>("v", "verbose", "d");
+    parser.add<FlagArg>("", "version", "d");
+    parser.add<ValueArg<std::string>>("o", "output", "d");
+    parser.add<FlagArg>(HIDDEN, "", "secret", "d");
+    bool built{false};
+    parser.addSubcommand("build", "d", [&built](ArgParser &) { built = true; });
+    parser.addSubcommand("bench", "d", [&built](ArgParser &) { built = true; });
+    const std::string data{parser.completionIndex()};
+    CHECK(!built);
+    const CompletionIndex index{data};
+    CHECK((index.complete("", "--ver") == std::vector<std::string>{"--verbose", "--version"}));
+    CHECK(index.complete("--codec", "z") == std::vector<std::string>{"zstd"});
+    CHECK(index.complete("-c", "").size() == 3);
+    // nothing after an argument that takes a value, so the shell can complete file names
+    CHECK(index.complete("-o", "").empty());
+    CHECK((index.complete("-v", "b") == std::vector<std::string>{"bench", "build"}));
+    CHECK(index.complete("", "--sec").empty());
+    const Check::TempFile file{"results.idx", data};
+    CompletionIndex opened;
+    CHECK(opened.open(file.path()) && opened.complete("--codec", "").size() == 3);
+    CHECK(!opened.open("results-missing.idx"));
+    const char *completing[]{"prog", "--complete", "--codec", "n"};
+    std::FILE *out{std::tmpfile()};
+    CHECK(index.answer(4, completing, out));
+    std::rewind(out);
+    char answer[16]{};
+    CHECK(std::fgets(answer, sizeof(answer), out) != nullptr && std::string{answer} == "none\n");
+    std::fclose(out);
+    const char *notCompleting[]{"prog", "--codec"};
+    CHECK(!index.answer(2, notCompleting));
+    const std::string script{CompletionIndex::script(BASH_SHELL, "my-tool")};
+    CHECK(script.find("\"my-tool\" --complete") != std::string::npos);
+}
+
+TEST(invalidCompletionIndexes) {
+    ArgParser parser;
+    parser.add<FlagArg>("v", "verbose", "d");
+    const std::string data{parser.completionIndex()};
+    for (const size_t length : {size_t{0}, size_t{3}, data.size() - 1})
+        CHECK_THROWS(std::invalid_argument, CompletionIndex{StringView(data.data(), length)});
+}
+
+TEST(snapshots) {
+    std::string snapshot;
+    {
+        Schema source;
+        source.parser.enableLazyConversion();
+        const std::string longText(300, 'q');
+        source.parser.parseCmd({"-n", "42", "--text", StringView{longText}, "--view", "hello", "-i",
+            "-f", "-t", "true", "-l", "a,b,c", "-c", "zstd", "run", "-x"});
+        snapshot = source.parser.snapshot();
+    }
+    Schema copy;
+    copy.parser.loadSnapshot(snapshot);
+    CHECK(copy.number->value() == 42 && copy.number->isSet());
+    CHECK(copy.ratio->value() == 0.5 && !copy.ratio->isSet() && copy.ratio->isDefined());
+    CHECK(copy.text->value() == std::string(300, 'q'));
+    // StringViews point into the snapshot
+    CHECK(copy.view->value() == "hello" && copy.view->value().data() >= snapshot.data()
+        && copy.view->value().data() < snapshot.data() + snapshot.size());
+    CHECK(copy.implicit->value() == 7 && copy.implicit->isDefined());
+    CHECK(copy.flag->value() && copy.flag->isSet() && copy.toggle->value());
+    CHECK(copy.list->value().size() == 3 && copy.list->value()[2] == "c");
+    CHECK(copy.codec->value() == Codec::ZSTD && copy.fallback->value() == Codec::NONE);
+    CHECK(copy.count->value() == 3u);
+    CHECK(copy.parser.subcommand() == "run" && copy.subcommandFlag->value());
+    CHECK(copy.parser.snapshot() == snapshot);
+    // a fresh parser's snapshot puts everything back to its default
+    Schema fresh;
+    const std::string defaults{fresh.parser.snapshot()};
+    copy.parser.loadSnapshot(defaults);
+    CHECK(!copy.number->isSet() && copy.fallback->value() == Codec::NONE && !copy.flag->value());
+}
+
+TEST(snapshotFiles) {
+    Schema source;
+    source.parser.parseCmd({"-n", "42", "--view", "hello"});
+    const Check::TempFile file{"results.snapshot", source.parser.snapshot()};
+    Schema copy;
+    CHECK(copy.parser.loadSnapshotFile(file.path()));
+    CHECK(copy.view->value() == "hello" && copy.number->value() == 42);
+    CHECK(!copy.parser.loadSnapshotFile("results-missing.snapshot"));
+}
+
+TEST(invalidSnapshots) {
+    Schema source;
+    source.parser.parseCmd({"-n", "1", "-f", "-t", "false"});
+    const std::string snapshot{source.parser.snapshot()};
+    // truncated snapshots, and ones with something after them, leave the parser alone
+    for (const size_t length : {size_t{0}, size_t{10}, snapshot.size() - 1}) {
+        Schema copy;
+        CHECK_THROWS(std::invalid_argument, copy.parser.loadSnapshot(StringView{snapshot.data(),
+            length}));
+        CHECK(!copy.number->isSet() && copy.ratio->isDefined());
+    }
+    Schema longer;
+    CHECK_THROWS(std::invalid_argument, longer.parser.loadSnapshot(snapshot + "x"));
+}
+
+TEST(invalidSnapshotBools) {
+    ArgParser source;
+    source.add<ValueArg<bool>>("b", "b", "d");
+    source.parseCmd({"-b", "true"});
+    std::string snapshot{source.snapshot()};
+    ArgParser copy;
+    auto toggle = copy.add<ValueArg<bool>>("b", "b", "d");
+    // the value is the last byte, and it has to be 0 or 1
+    CHECK(snapshot.back() == 1);
+    snapshot.back() = 7;
+    CHECK_THROWS(std::invalid_argument, copy.loadSnapshot(snapshot));
+    CHECK(!toggle->isSet());
+}
+
+TEST(snapshotsOfOtherParsers) {
+    ArgParser integer;
+    integer.add<ValueArg<int>>("x", "x", "d");
+    const std::string snapshot{integer.snapshot()};
+    ArgParser same;
+    same.add<ValueArg<int>>("x", "x", "d");
+    same.loadSnapshot(snapshot);
+    // the same names with a different kind or value type don't match
+    ArgParser floating;
+    floating.add<ValueArg<float>>("x", "x", "d");
+    ArgParser implicit;
+    implicit.add<ImplicitArg<int>>("x", "x", "d", 1);
+    ArgParser choice;
+    choice.add<ChoiceArg<int>>("x", "x", "d", ChoiceArg<int>::Choices{{"a", 1}});
+    ArgParser list;
+    list.add<ListArg<int>>("x", "x", "d");
+    ArgParser fewer;
+    for (ArgParser *parser : {&floating, &implicit, &choice, &list, &fewer})
+        CHECK_THROWS(std::invalid_argument, parser->loadSnapshot(snapshot));
+}
+
+TEST(reloadableResults) {
+    ArgParser parser;
+    auto threads = parser.add<ValueArg<int>>("t", "threads", "d", 4);
+    auto name = parser.add<ValueArg<std::string>>("n", "name", "d");
+    parser.require(name);
+    CHECK_THROWS(std::logic_error, ReloadableResult{parser});
+    parser.freeze();
+    // starting out with the defaults doesn't need the required argument
+    ReloadableResult options{parser};
+    ReloadableResult::Reader reader{options};
+    {
+        auto view = reader.read();
+        CHECK(view->value(threads) == 4 && !view->isSet(name));
+        // a view keeps the result it started with, even once another one is published
+        options.publish(parser.parse({"-t", "8", "-n", "x"}));
+        CHECK(view->value(threads) == 4 && options.generation() == 1);
+    }
+    CHECK(reader.read()->value(threads) == 8 && reader.read()->value(name) == "x");
+    // a reload that fails leaves the old values
+    CHECK_THROWS(std::invalid_argument, options.publish(parser.parse({"-t", "x"})));
+    CHECK(reader.read()->value(threads) == 8);
+    options.collect();
+    ReloadableResult started{parser.parse({"-n", "y"})};
+    ReloadableResult::Reader startedReader{started};
+    CHECK(startedReader.read()->value(name) == "y");
+}
+
+TEST(reloadingConfigFiles) {
+    const Check::TempFile file{"results.conf", "threads = 16\n"};
+    ArgParser parser;
+    auto threads = parser.add<ValueArg<int>>("t", "threads", "d", 4);
+    parser.freeze();
+    ReloadableResult options{parser};
+    ParseResult fresh{parser.parse({})};
+    parser.parseConfigFile(fresh, file.path());
+    options.publish(std::move(fresh));
+    ReloadableResult::Reader reader{options};
+    CHECK(reader.read()->value(threads) == 16 && !reader.read()->isSet(threads));
+    CHECK(threads->value() == 4);
+}
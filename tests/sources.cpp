@@ -0,0 +1,178 @@
+// tests for values that don't come straight from the command
+#include <cstdlib>
+#include "check.hpp"
+#include "cmd-args.hpp"
+using namespace CmdArgs;
+
+TEST(responseFiles) {
+    const Check::TempFile file{"sources-ok.rsp", "-v 7 'a b' \"c d\"\n--flag"};
+    ArgParser parser;
+    auto value = parser.add<ValueArg<int>>("v", "value", "d");
+    auto flag = parser.add<FlagArg>("f", "flag", "d");
+    auto first = parser.addPositional<ValueArg<std::string>>("first", "d");
+    auto second = parser.addPositional<ValueArg<std::string>>("second", "d");
+    // they're off by default
+    parser.parseCmd({"@sources-ok.rsp"});
+    CHECK(first->value() == "@sources-ok.rsp" && !value->isSet());
+    parser.reset();
+    parser.enableResponseFiles();
+    parser.parseCmd({"@sources-ok.rsp"});
+    CHECK(value->value() == 7 && flag->value());
+    CHECK(first->value() == "a b" && second->value() == "c d");
+    parser.reset();
+    // a file that can't be opened is left alone
+    parser.parseCmd({"@sources-missing.rsp"});
+    CHECK(first->value() == "@sources-missing.rsp");
+    // reading the same file again is fine, and parse() reads them too
+    for (int i = 0; i < 10; ++i) {
+        parser.reset();
+        parser.parseCmd({"@sources-ok.rsp"});
+    }
+    CHECK(value->value() == 7);
+    parser.freeze();
+    const ParseResult result{parser.parse({"@sources-ok.rsp"})};
+    CHECK(result.value(value) == 7 && result.value(second) == "c d");
+}
+
+TEST(responseFileCycles) {
+    const Check::TempFile a{"sources-a.rsp", "-v 1 @sources-b.rsp"};
+    const Check::TempFile b{"sources-b.rsp", "@sources-a.rsp"};
+    const Check::TempFile self{"sources-self.rsp", "@sources-self.rsp"};
+    ArgParser parser;
+    parser.enableResponseFiles();
+    parser.add<ValueArg<int>>("v", "value", "d");
+    CHECK_THROWS_MESSAGE(std::invalid_argument, parser.parseCmd({"@sources-a.rsp"}),
+        "Response files include each other in a cycle: sources-a.rsp -> sources-b.rsp -> "
+        "sources-a.rsp\n");
+    parser.reset();
+    CHECK_THROWS(std::invalid_argument, parser.parseCmd({"@sources-self.rsp"}));
+    parser.reset();
+    const ParseStatus status{parser.tryParseCmd({"@sources-a.rsp"})};
+    CHECK(status.errors().size() == 1);
+    CHECK(status.errors()[0].kind == ParseError::RESPONSE_FILE_CYCLE);
+}
+
+TEST(environmentVariables) {
+    setenv("SOURCES_THREAD_COUNT", "12", 1);
+    setenv("SOURCES_NAME", "from the environment", 1);
+    setenv("SOURCES_QUIET", "0", 1);
+    setenv("OTHER_THREAD_COUNT", "99", 1);
+    ArgParser parser;
+    auto threads = parser.add<ValueArg<int>>("t", "thread-count", "d", 4);
+    auto name = parser.add<ValueArg<StringView>>("n", "name", "d");
+    auto scale = parser.add<ValueArg<double>>("s", "", "d", 1.5);
+    auto quiet = parser.add<FlagArg>("q", "quiet", "d");
+    parser.setEnvPrefix("SOURCES_");
+    parser.bindEnv(threads);
+    parser.bindEnv(name);
+    parser.bindEnv(scale);
+    parser.bindEnv(quiet);
+    // the command wins over the environment, which wins over the default
+    parser.parseCmd({"-n", "cli"});
+    CHECK(threads->value() == 12 && !threads->isSet() && threads->isDefined());
+    CHECK(name->value() == "cli" && name->isSet() && scale->value() == 1.5 && !quiet->value());
+    parser.reset();
+    parser.parseCmd({"-t", "3"});
+    CHECK(threads->value() == 3 && name->value() == "from the environment" && !name->isSet());
+    parser.freeze();
+    const ParseResult result{parser.parse({"-s", "2"})};
+    CHECK(result.value(threads) == 12 && result.value(scale) == 2);
+    unsetenv("SOURCES_THREAD_COUNT");
+    unsetenv("SOURCES_NAME");
+    unsetenv("SOURCES_QUIET");
+    unsetenv("OTHER_THREAD_COUNT");
+}
+
+TEST(invalidEnvironmentVariables) {
+    setenv("SOURCES_BAD", "zz", 1);
+    ArgParser parser;
+    auto bad = parser.add<ValueArg<int>>("b", "bad", "d");
+    parser.setEnvPrefix("SOURCES_");
+    parser.bindEnv(bad, "BAD");
+    CHECK_THROWS(std::invalid_argument, parser.parseCmd({}));
+    parser.reset();
+    const ParseStatus status{parser.tryParseCmd({})};
+    CHECK(status.errors().size() == 1);
+    CHECK(status.errors()[0].kind == ParseError::INVALID_ENVIRONMENT_VALUE);
+    CHECK(status.errors()[0].value == "SOURCES_BAD=zz");
+    CHECK(status.errors()[0].token == ParseError::npos);
+    // arguments from other parsers can't be bound
+    ArgParser other;
+    CHECK_THROWS(std::invalid_argument, other.bindEnv(bad));
+    unsetenv("SOURCES_BAD");
+}
+
+TEST(configFiles) {
+    const Check::TempFile file{"sources.conf",
+        "# comment\n; other comment\n\nthreads = 8\nname = \"hello world\" # trailing\n"
+        "verbose = true\r\n[server]\nport = 80\nhost = abc#1  # trailing\n[a.b]\nc_d = -5\n"
+        "unknown = 1\n[]\nids=1,2,3\nlevel =\n"};
+    ArgParser parser;
+    auto threads = parser.add<ValueArg<int>>("t", "threads", "d", 1);
+    auto name = parser.add<ValueArg<StringView>>("", "name", "d");
+    auto verbose = parser.add<FlagArg>("v", "verbose", "d");
+    auto port = parser.add<ValueArg<int>>("", "server-port", "d");
+    auto host = parser.add<ValueArg<std::string>>("", "server-host", "d");
+    auto nested = parser.add<ValueArg<int>>("", "a-b-c_d", "d");
+    auto ids = parser.add<ListArg<int>>("", "ids", "d", std::vector<int>{9});
+    auto level = parser.add<ImplicitArg<int>>("", "level", "d", 7);
+    parser.parseCmd({"-t", "2", "--ids", "4"});
+    parser.parseConfigFile(file.path());
+    // arguments that were set in the command are left alone
+    CHECK(threads->value() == 2 && threads->isSet());
+    CHECK((ids->value() == std::vector<int>{4}));
+    CHECK(name->value() == "hello world" && name->isDefined() && !name->isSet());
+    CHECK(verbose->value() && port->value() == 80 && host->value() == "abc#1");
+    CHECK(nested->value() == -5 && level->value() == 7 && level->isDefined());
+    parser.reset();
+    parser.parseConfigFile(file.path());
+    CHECK(threads->value() == 8 && (ids->value() == std::vector<int>{1, 2, 3}));
+}
+
+TEST(configFilesAndTheEnvironment) {
+    const Check::TempFile file{"sources-env.conf", "threads = 8\nport = 80\nname = config\n"};
+    setenv("SOURCES_PORT", "9000", 1);
+    setenv("SOURCES_NAME", "env", 1);
+    ArgParser parser;
+    auto threads = parser.add<ValueArg<int>>("t", "threads", "d", 1);
+    auto port = parser.add<ValueArg<int>>("p", "port", "d", 443);
+    auto name = parser.add<ValueArg<std::string>>("n", "name", "d");
+    parser.setEnvPrefix("SOURCES_");
+    parser.bindEnv(port);
+    parser.bindEnv(name);
+    // the command wins over the environment, which wins over the config file, either way around
+    parser.parseCmd({"-n", "cli"});
+    parser.parseConfigFile(file.path());
+    CHECK(threads->value() == 8 && port->value() == 9000 && name->value() == "cli");
+    parser.reset();
+    parser.parseConfigFile(file.path());
+    parser.parseCmd({"-n", "cli"});
+    CHECK(threads->value() == 8 && port->value() == 9000 && name->value() == "cli");
+    // reset() forgets where the values came from
+    parser.reset();
+    unsetenv("SOURCES_PORT");
+    parser.parseConfigFile(file.path());
+    CHECK(port->value() == 80 && name->value() == "config");
+    // the same goes for results from parse()
+    setenv("SOURCES_PORT", "9000", 1);
+    ParseResult result{parser.parse({"-t", "2"})};
+    parser.parseConfigFile(result, file.path());
+    CHECK(result.value(threads) == 2 && result.value(port) == 9000 && result.value(name) == "env");
+    unsetenv("SOURCES_PORT");
+    unsetenv("SOURCES_NAME");
+    const std::vector<std::string> empty;
+    parser.parse(result, empty.begin(), empty.end());
+    parser.parseConfigFile(result, file.path());
+    CHECK(result.value(port) == 80 && result.value(name) == "config");
+}
+
+TEST(invalidConfigFiles) {
+    const Check::TempFile section{"sources-section.conf", "threads = 1\n[x\n"};
+    const Check::TempFile value{"sources-value.conf", "threads = x\n"};
+    ArgParser parser;
+    parser.add<ValueArg<int>>("t", "threads", "d", 1);
+    CHECK_THROWS(std::invalid_argument, parser.parseConfigFile(section.path()));
+    CHECK_THROWS(std::invalid_argument, parser.parseConfigFile(value.path()));
+    CHECK_THROWS_MESSAGE(std::invalid_argument, parser.parseConfigFile("sources-missing.conf"),
+        "Config file sources-missing.conf couldn't be opened\n");
+}
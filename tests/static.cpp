@@ -0,0 +1,52 @@
+// tests for StaticArgParser
+#include "check.hpp"
+#include "cmd-args.hpp"
+using namespace CmdArgs;
+
+CMD_ARGS_STATIC_VALUE(Threads, int, "t", "threads", "how many threads to use");
+CMD_ARGS_STATIC_VALUE_DEFAULT(Scale, double, "s", "scale", "a scale factor", 0.5);
+CMD_ARGS_STATIC_VALUE_DEFAULT(Name, std::string, "", "name", "a name", "bob");
+CMD_ARGS_STATIC_IMPLICIT(Level, int, "l", "level", "how much to log", 3);
+CMD_ARGS_STATIC_FLAG(Verbose, "v", "verbose", "print everything");
+
+typedef StaticArgParser<Threads, Scale, Name, Level, Verbose> Parser;
+
+TEST(staticValues) {
+    Parser parser;
+    CHECK(parser.value<Scale>() == 0.5 && parser.value<Name>() == "bob");
+    CHECK(!parser.value<Verbose>());
+    parser.parseCmd({"--threads", "8", "-l", "-v", "--name", "al"});
+    CHECK(parser.value<Threads>() == 8 && parser.isSet<Threads>());
+    CHECK(parser.value<Scale>() == 0.5 && !parser.isSet<Scale>() && parser.isDefined<Scale>());
+    CHECK(parser.value<Name>() == "al" && parser.value<Verbose>());
+    CHECK(parser.value<Level>() == 3 && !parser.isSet<Level>() && parser.isDefined<Level>());
+    parser.reset();
+    CHECK(!parser.isSet<Threads>() && parser.value<Name>() == "bob" && !parser.value<Verbose>());
+    const char *argv[]{"prog", "-s", "2.5", "-l", "4"};
+    parser.parseCmd(5, argv);
+    CHECK(parser.value<Scale>() == 2.5 && parser.value<Level>() == 4 && parser.isSet<Level>());
+}
+
+TEST(staticErrors) {
+    Parser parser;
+    CHECK_THROWS(std::invalid_argument, parser.parseCmd({"-t", "x"}));
+    parser.reset();
+    CHECK_THROWS(std::invalid_argument, parser.parseCmd({"-t", "-v"}));
+    parser.reset();
+    CHECK_THROWS(std::invalid_argument, parser.parseCmd({"-t"}));
+}
+
+TEST(staticResponseFiles) {
+    const Check::TempFile file{"static.rsp", "-t 6 --verbose"};
+    Parser parser;
+    parser.enableResponseFiles();
+    parser.parseCmd({"@static.rsp"});
+    CHECK(parser.value<Threads>() == 6 && parser.value<Verbose>());
+}
+
+TEST(staticHelpMessages) {
+    Parser parser;
+    const std::string help{parser.createHelpMessage()};
+    CHECK(help.find("--threads") != std::string::npos && help.find("=0.5") != std::string::npos);
+    CHECK(help.find("print everything") != std::string::npos);
+}
@@ -0,0 +1,51 @@
+// tests for ParseStats and ParseHooks, which this test turns on with CMD_ARGS_STATS
+#include "check.hpp"
+// before cmd-args.hpp, so the declarations of ParseStats and ParseHooks are checked too
+#include "cmd-args-fwd.hpp"
+#include "cmd-args.hpp"
+using namespace CmdArgs;
+
+static_assert(CMD_ARGS_STATS, "stats.cpp has to be built with CMD_ARGS_STATS=1");
+
+struct Trace : ParseHooks {
+    int started{0}, parsed{0}, unknown{0}, finished{0};
+    std::vector<std::string> values;
+
+    void parseStarted() override { ++started; }
+    void argumentParsed(const Argument &arg, StringView value, uint64_t) override {
+        ++parsed;
+        values.push_back(arg.longName.str() + "=" + value.str());
+    }
+    void unknownToken(StringView) override { ++unknown; }
+    void parseFinished(const ParseStats &, uint64_t) override { ++finished; }
+};
+
+TEST(parseStats) {
+    ArgParser parser;
+    auto threads = parser.add<ValueArg<int>>("t", "threads", "d", 1);
+    parser.add<FlagArg>("v", "verbose", "d");
+    parser.parseCmd({"-t", "4", "--oops", "-v"});
+    const ParseStats &stats{parser.stats()};
+    CHECK(stats.parses == 1 && stats.tokens == 4 && stats.hits == 2 && stats.misses == 2);
+    CHECK(stats.conversions.size() == 2 && stats.conversions[0].count == 1);
+    CHECK(stats.conversions[0].argument == threads.get());
+    // parse() keeps its own stats in the result
+    parser.freeze();
+    const ParseResult result{parser.parse({"-v"})};
+    CHECK(result.stats().parses == 1 && result.stats().hits == 1 && parser.stats().parses == 1);
+    parser.resetStats();
+    CHECK(parser.stats().parses == 0 && parser.stats().tokens == 0);
+}
+
+TEST(parseHooks) {
+    ArgParser parser;
+    parser.add<ValueArg<int>>("t", "threads", "d", 1);
+    parser.add<FlagArg>("v", "verbose", "d");
+    Trace trace;
+    parser.setHooks(&trace);
+    parser.parseCmd({"-t", "4", "--oops", "-v"});
+    parser.freeze();
+    (void)parser.parse({"-v"});
+    CHECK(trace.started == 2 && trace.finished == 2 && trace.unknown == 2 && trace.parsed == 3);
+    CHECK(!trace.values.empty() && trace.values[0] == "--threads=4");
+}
@@ -0,0 +1,176 @@
+// tests for how arguments are stored, named, and described
+#include <sstream>
+#include <type_traits>
+#include "check.hpp"
+// before cmd-args.hpp, so a declaration in it that doesn't match is an error
+#include "cmd-args-fwd.hpp"
+#include "cmd-args.hpp"
+using namespace CmdArgs;
+
+static_assert(!std::is_copy_constructible<ArgParser>::value, "");
+static_assert(std::is_nothrow_move_constructible<ArgParser>::value, "");
+static_assert(std::is_nothrow_move_assignable<ArgParser>::value, "");
+
+static ArgParser makeParser(Storage storage, std::shared_ptr<ValueArg<int>> &number) {
+    ArgParser parser{storage};
+    number = parser.add<ValueArg<int>>("n", "number", "d", 1);
+    parser.add<FlagArg>("f", "flag", "d");
+    parser.require(number);
+    return parser;
+}
+
+static const char *const borrowed{"borrowed text"};
+
+static std::shared_ptr<ValueArg<int>> addWithLocalDescription(ArgParser &parser) {
+    const char description[]{"a local array"};
+    return parser.add<ValueArg<int>>("a", "a", description);
+}
+
+TEST(arenaStorage) {
+    ArgParser parser{ARENA_STORAGE, 256};
+    std::vector<std::shared_ptr<ValueArg<int>>> options;
+    for (int i = 0; i < 100; ++i)
+        options.push_back(parser.add<ValueArg<int>>("", "opt" + std::to_string(i), "d", i));
+    auto flag = parser.add<FlagArg>("f", "flag", std::string{"in the arena"});
+    // the pointers don't own anything
+    CHECK(flag.use_count() == 0);
+    parser.parseCmd({"--opt42", "7", "-f"});
+    CHECK(options[42]->value() == 7 && options[41]->value() == 41 && flag->value());
+    CHECK(options[99]->longName == "--opt99" && flag->description == "in the arena");
+}
+
+TEST(namelessArguments) {
+    for (const Storage storage : {SHARED_STORAGE, ARENA_STORAGE}) {
+        ArgParser parser{storage};
+        CHECK_THROWS_MESSAGE(std::invalid_argument, parser.add<ValueArg<int>>("", "", "d"),
+            "Command-line arguments must have at least one name\n");
+        // a nameless argument doesn't leave anything behind
+        auto number = parser.add<ValueArg<int>>("n", "n", "d");
+        parser.parseCmd({"-n", "3"});
+        CHECK(number->value() == 3 && number->isSet());
+    }
+    // arguments that aren't in a parser don't need names
+    const ValueArg<int> standalone{"", "", "d"};
+    CHECK(standalone.shortName.empty() && standalone.longName.empty());
+}
+
+TEST(helpMessages) {
+    ArgParser parser;
+    parser.add<ValueArg<int>>("v", "value", "a value", 42);
+    parser.add<ImplicitArg<int>>("i", "implicit", "an implicit value", 37);
+    parser.add<FlagArg>(HIDDEN, "h", "hidden", "a hidden flag");
+    parser.add<FlagArg>(INVISIBLE, "", "invisible", "an invisible flag");
+    const std::string help{parser.createHelpMessage()};
+    CHECK(help.find("[[Allowed Arguments]]") == 0);
+    CHECK(help.find("--value =42") != std::string::npos);
+    CHECK(help.find("=arg(=37)") != std::string::npos);
+    CHECK(help.find("--hidden") == std::string::npos);
+    CHECK(help.find("--invisible") == std::string::npos);
+    const std::string withHidden{parser.createHelpMessage(true)};
+    CHECK(withHidden.find("[[Hidden Arguments]]") != std::string::npos);
+    CHECK(withHidden.find("--invisible") == std::string::npos);
+    // streaming it gives the same message, and adding an argument works the widths out again
+    std::ostringstream stream;
+    parser.createHelpMessage(stream, true);
+    CHECK(stream.str() == withHidden);
+    parser.add<ListArg<int>>("", "a-much-longer-list-name", "a list", std::vector<int>{1, 2});
+    const std::string wider{parser.createHelpMessage()};
+    CHECK(wider.find("--a-much-longer-list-name") != std::string::npos);
+    CHECK(wider.size() > help.size());
+}
+
+TEST(outlivingTheParser) {
+    std::shared_ptr<ValueArg<int>> number, lazy, defaulted, position;
+    std::shared_ptr<FlagArg> flag;
+    {
+        ArgParser parser;
+        parser.enableLazyConversion();
+        const std::string description{"a description that isn't a literal"};
+        number = parser.add<ValueArg<int>>("n", "number", description);
+        lazy = parser.add<ValueArg<int>>("l", "lazy", "d");
+        defaulted = parser.add<ValueArg<int>>("d", "defaulted", "d", 4);
+        flag = parser.add<FlagArg>("f", "flag", "d");
+        position = parser.addPositional<ValueArg<int>>("count", StringView{description});
+        parser.parseCmd({"-n", "5", "-l", "6", "-f", "7"});
+        CHECK(number->value() == 5);
+    }
+    // the arguments keep their values, and what isSet() and isDefined() returned
+    CHECK(number->value() == 5 && number->isSet() && number->isDefined());
+    CHECK(lazy->value() == 6 && flag->value() && flag->isSet());
+    CHECK(defaulted->value() == 4 && !defaulted->isSet() && defaulted->isDefined());
+    CHECK(position->value() == 7 && position->description == "a description that isn't a literal");
+    CHECK(number->longName == "--number" && number->shortName == "-n");
+}
+
+TEST(setArguments) {
+    ArgParser parser;
+    parser.add<ValueArg<int>>("v", "value", "d");
+    parser.add<ValueArg<int>>("", "fallback", "d", 42);
+    parser.add<FlagArg>("f", "flag", "d");
+    parser.parseCmd({"-v", "53", "--flag"});
+    CHECK(parser.setCount() == 2);
+    std::vector<StringView> set;
+    parser.forEachSet([&set](const Argument &arg) { set.push_back(arg.longName); });
+    CHECK(set.size() == 2 && set[0] == "--value" && set[1] == "--flag");
+    parser.reset();
+    CHECK(parser.setCount() == 0);
+    const ParseResult result{parser.parse({"-f"})};
+    CHECK(result.setCount() == 1 && parser.setCount() == 0);
+}
+
+TEST(movingParsers) {
+    for (const Storage storage : {SHARED_STORAGE, ARENA_STORAGE}) {
+        std::shared_ptr<ValueArg<int>> number;
+        ArgParser made{makeParser(storage, number)};
+        ArgParser parser{std::move(made)};
+        parser.parseCmd({"-n", "5"});
+        CHECK(number->value() == 5 && number->isSet());
+        parser.reset();
+        CHECK_THROWS(std::invalid_argument, parser.parseCmd({"-f"}));
+        // the arguments follow their parser around as a vector grows
+        std::vector<ArgParser> parsers;
+        std::vector<std::shared_ptr<ValueArg<int>>> numbers(100);
+        for (size_t i = 0; i < numbers.size(); ++i) {
+            parsers.push_back(makeParser(storage, numbers[i]));
+        }
+        parsers[42].parseCmd({"-n", "42"});
+        CHECK(numbers[42]->value() == 42 && numbers[42]->isSet() && !numbers[41]->isSet());
+        CHECK(parsers[42].setCount() == 1 && parsers[0].setCount() == 0);
+        CHECK(parsers[0].createHelpMessage().find("--number") != std::string::npos);
+    }
+    // the arguments of a parser that's assigned over are cut loose, like they are when it's
+    // destroyed
+    std::shared_ptr<ValueArg<int>> first, second;
+    ArgParser parser{makeParser(SHARED_STORAGE, first)};
+    parser.parseCmd({"-n", "3"});
+    parser = makeParser(SHARED_STORAGE, second);
+    CHECK(first->value() == 3 && first->isSet());
+    parser.parseCmd({"-n", "4"});
+    CHECK(second->value() == 4 && second->isSet() && first->value() == 3);
+}
+
+TEST(names) {
+    ArgParser parser;
+    auto alpha = parser.add<ValueArg<int>>("a", "alpha", "d", 1);
+    auto shortOnly = parser.add<FlagArg>("c", "", "d");
+    CHECK(alpha->shortName == "-a" && alpha->longName == "--alpha");
+    CHECK(shortOnly->longName.empty());
+    const std::string name = alpha->longName;
+    CHECK(name == "--alpha");
+}
+
+TEST(descriptions) {
+    ArgParser parser;
+    auto local = addWithLocalDescription(parser);
+    CHECK(local->description == "a local array");
+    char buffer[]{"mutable"};
+    auto copied = parser.add<FlagArg>("b", "b", buffer);
+    buffer[0] = 'X';
+    CHECK(copied->description == "mutable");
+    auto fromString = parser.add<FlagArg>("c", "c", std::string{"a std::string"});
+    auto fromView = parser.add<FlagArg>("d", "d", StringView{"a view"});
+    CHECK(fromString->description == "a std::string" && fromView->description == "a view");
+    // a literal description isn't copied
+    auto literal = parser.add<ValueArg<int>>("e", "e", Description::literal(borrowed));
+    CHECK(literal->description.data() == borrowed);
+}
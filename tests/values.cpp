@@ -0,0 +1,227 @@
+// tests for converting values
+#include "check.hpp"
+#include "cmd-args.hpp"
+using namespace CmdArgs;
+
+struct Duration {
+    int seconds;
+};
+
+template <> Duration CmdArgs::stringToType<Duration>(const std::string &str) {
+    if (str.empty() || str.back() != 's') throw std::invalid_argument("not a duration\n");
+    return Duration{stringToType<int>(str.substr(0, str.size() - 1))};
+}
+
+template <> std::string CmdArgs::typeToString<Duration>(const Duration duration) {
+    return std::to_string(duration.seconds) + "s";
+}
+
+enum class Codec { LZ4, ZSTD, NONE };
+
+TEST(integers) {
+    CHECK(stringToType<int>("42") == 42 && stringToType<int>("+7") == 7);
+    CHECK(stringToType<int>("-2147483648") == -2147483647 - 1);
+    CHECK(stringToType<unsigned>("4294967295") == 4294967295u);
+    CHECK(stringToType<short>("-32768") == -32768);
+    CHECK_THROWS(std::invalid_argument, stringToType<int>("2147483648"));
+    CHECK_THROWS(std::invalid_argument, stringToType<int>("53abc"));
+    CHECK_THROWS(std::invalid_argument, stringToType<int>(""));
+    CHECK_THROWS(std::invalid_argument, stringToType<int>("-"));
+    CHECK_THROWS(std::invalid_argument, stringToType<int>(" 42"));
+    CHECK_THROWS(std::invalid_argument, stringToType<unsigned>("-1"));
+    CHECK_THROWS(std::invalid_argument, stringToType<short>("-32769"));
+}
+
+TEST(floatingPoint) {
+    CHECK(stringToType<double>("3.25") == 3.25 && stringToType<double>("-0.5") == -0.5);
+    CHECK(stringToType<double>(".5") == 0.5 && stringToType<double>("5.") == 5.0);
+    CHECK(stringToType<float>("3.4e38") > 3e38f && stringToType<long double>("1.5") == 1.5L);
+    CHECK_THROWS(std::invalid_argument, stringToType<double>("1e309"));
+    CHECK_THROWS(std::invalid_argument, stringToType<float>("1e39"));
+    CHECK_THROWS(std::invalid_argument, stringToType<double>("."));
+    CHECK_THROWS(std::invalid_argument, stringToType<double>("1e"));
+    CHECK_THROWS(std::invalid_argument, stringToType<double>("1.5x"));
+}
+
+TEST(bools) {
+    CHECK(stringToType<bool>("TRUE") && stringToType<bool>("1"));
+    CHECK(!stringToType<bool>("False") && !stringToType<bool>("0"));
+    CHECK_THROWS_MESSAGE(std::invalid_argument, stringToType<bool>("yes"),
+        "Couldn't convert string \"yes\" to type bool\n");
+}
+
+TEST(customTypes) {
+    ArgParser parser;
+    auto timeout = parser.add<ValueArg<Duration>>("t", "timeout", "d", Duration{30});
+    auto name = parser.add<ValueArg<std::string>>("n", "name", "d");
+    parser.parseCmd({"-t", "5s", "-n", "hello world"});
+    CHECK(timeout->value().seconds == 5 && name->value() == "hello world");
+    CHECK(parser.createHelpMessage().find("=30s") != std::string::npos);
+    parser.reset();
+    CHECK_THROWS(std::invalid_argument, parser.parseCmd({"-t", "5"}));
+}
+
+TEST(stringViews) {
+    ArgParser parser;
+    auto blob = parser.add<ValueArg<StringView>>("b", "blob", "d", "none");
+    auto implicit = parser.add<ImplicitArg<StringView>>("i", "imp", "d", "set", "unset");
+    CHECK(blob->value() == "none" && implicit->value() == "unset");
+    const char *argv[]{"prog", "--blob", "AAAABBBBCCCCDDDD", "-i"};
+    parser.parseCmd(4, argv);
+    // the value points straight into argv
+    CHECK(blob->value().data() == argv[2] && blob->value().length() == 16);
+    CHECK(implicit->value() == "set" && implicit->defaultValue() == "unset");
+    const std::string copy{blob->value()};
+    CHECK(copy == blob->value().str() && copy == "AAAABBBBCCCCDDDD");
+}
+
+TEST(lists) {
+    ArgParser parser;
+    auto ids = parser.add<ListArg<int>>("i", "ids", "d", std::vector<int>{9, 8});
+    auto paths = parser.add<ListArg<std::string>>("p", "paths", "d", Delimiter{':'});
+    CHECK((ids->value() == std::vector<int>{9, 8}));
+    parser.parseCmd({"-i", "1", "--ids", "2,3", "-p", "/bin:/usr/bin"});
+    CHECK((ids->value() == std::vector<int>{1, 2, 3}));
+    CHECK((paths->value() == std::vector<std::string>{"/bin", "/usr/bin"}));
+}
+
+TEST(longLists) {
+    ArgParser parser;
+    auto ids = parser.add<ListArg<int>>("i", "ids", "d");
+    std::string list;
+    for (int i = 0; i < 100000; ++i) list += std::to_string(i % 2 ? -i : i) + ",";
+    list.pop_back();
+    parser.parseCmd({"-i", StringView{list}});
+    CHECK(ids->value().size() == 100000 && ids->value()[0] == 0);
+    CHECK(ids->value()[99998] == 99998 && ids->value()[99999] == -99999);
+}
+
+TEST(invalidListElements) {
+    ArgParser parser;
+    auto ids = parser.add<ListArg<int>>("i", "ids", "d", std::vector<int>{9, 8});
+    const ParseStatus status{parser.tryParseCmd({"-i", "1,x,3"})};
+    CHECK(status.errors().size() == 1 && status.errors()[0].kind == ParseError::INVALID_ELEMENT);
+    CHECK(parser.errorMessage(status.errors()[0]).find("\"x\"") != std::string::npos);
+    // an invalid element leaves the list the way it was
+    CHECK((ids->value() == std::vector<int>{9, 8}) && !ids->isSet());
+    parser.reset();
+    parser.parseCmd({"-i", "1,2"});
+    CHECK(!parser.tryParseCmd({"-i", "3,y"}).ok());
+    CHECK((ids->value() == std::vector<int>{1, 2}));
+    parser.reset();
+    CHECK_THROWS(std::invalid_argument, parser.parseCmd({"-i", "a"}));
+    CHECK((ids->value() == std::vector<int>{9, 8}));
+}
+
+TEST(repeatedLists) {
+    ArgParser parser;
+    auto ids = parser.add<ListArg<int>>("i", "ids", "d", std::vector<int>{9});
+    std::vector<std::string> tokens;
+    for (int i = 0; i < 100000; ++i) {
+        tokens.push_back("-i");
+        tokens.push_back(std::to_string(i));
+    }
+    // every occurrence is appended to the same list, and growing it stays linear
+    parser.parseCmd(tokens.begin(), tokens.end());
+    CHECK(ids->value().size() == 100000 && ids->value()[0] == 0);
+    CHECK(ids->value()[54321] == 54321 && ids->value()[99999] == 99999);
+}
+
+TEST(shellTokens) {
+    const std::string command{"  a\\ b 'c d'e \"f\\\"g\" '' x\"\"y plain"};
+    std::vector<char> buffer(command.size());
+    std::vector<std::string> tokens;
+    for (StringView token : ShellTokens{command, buffer.data()}) tokens.push_back(token.str());
+    CHECK((tokens == std::vector<std::string>{"a b", "c de", "f\"g", "", "xy", "plain"}));
+    // tokens that don't need unescaping point into the string
+    std::string inPlace{"--jobs 4 'x y'"};
+    std::vector<StringView> views;
+    for (StringView token : ShellTokens{&inPlace[0], inPlace.size()}) views.push_back(token);
+    CHECK(views.size() == 3 && views[0].data() == inPlace.data() && views[2] == "x y");
+    std::string unterminated{"'abc"};
+    CHECK_THROWS_MESSAGE(std::invalid_argument,
+        for (StringView token : ShellTokens{&unterminated[0], unterminated.size()}) (void)token,
+        "Command string has an unterminated quote\n");
+    std::string backslash{"abc\\"};
+    CHECK_THROWS_MESSAGE(std::invalid_argument,
+        for (StringView token : ShellTokens{&backslash[0], backslash.size()}) (void)token,
+        "Command string ends with a backslash\n");
+}
+
+TEST(parsingShellTokens) {
+    ArgParser parser;
+    auto value = parser.add<ValueArg<int>>("v", "value", "d");
+    auto text = parser.add<ImplicitArg<StringView>>("", "text", "d", "none");
+    auto flag = parser.add<FlagArg>("", "flag", "d");
+    std::string command{"-v 53 --text \"hi there!\" --flag"};
+    parser.parseCmd(ShellTokens{&command[0], command.size()});
+    CHECK(value->value() == 53 && text->value() == "hi there!" && flag->value());
+}
+
+TEST(lazyConversion) {
+    ArgParser parser;
+    parser.enableLazyConversion();
+    auto number = parser.add<ValueArg<int>>("n", "number", "d");
+    auto jobs = parser.add<ValueArg<int>>("j", "jobs", "d");
+    auto level = parser.add<ImplicitArg<int>>("l", "level", "d", 3);
+    auto position = parser.addPositional<ValueArg<int>>("pos", "d");
+    // invalid values aren't noticed until they're read
+    parser.parseCmd({"--number=x", "-jy", "--level=z", "w"});
+    CHECK(number->isSet() && jobs->isSet() && level->isSet() && position->isSet());
+    CHECK_THROWS(std::invalid_argument, number->value());
+    CHECK_THROWS(std::invalid_argument, jobs->value());
+    CHECK_THROWS(std::invalid_argument, level->value());
+    CHECK_THROWS(std::invalid_argument, position->value());
+    CHECK_THROWS(std::invalid_argument, parser.validateAll());
+    parser.reset();
+    parser.parseCmd({"--number=-4", "-j8", "--level=", "5"});
+    parser.validateAll();
+    CHECK(number->value() == -4 && jobs->value() == 8 && level->value() == 3 && !level->isSet());
+    CHECK(position->value() == 5);
+    parser.reset();
+    // missing values are still reported right away
+    CHECK_THROWS(std::invalid_argument, parser.parseCmd({"-n"}));
+}
+
+TEST(choices) {
+    ArgParser parser;
+    auto codec = parser.add<ChoiceArg<Codec>>("c", "codec", "d",
+        ChoiceArg<Codec>::Choices{{"lz4", Codec::LZ4}, {"zstd", Codec::ZSTD},
+            {"none", Codec::NONE}},
+        Codec::NONE);
+    auto mode = parser.add<ChoiceArg<int>>("m", "mode", "d",
+        ChoiceArg<int>::Choices{{"a", 1}, {"b", 2}});
+    CHECK(codec->value() == Codec::NONE && codec->hasDefault() && !mode->isDefined());
+    CHECK(codec->nameOf(Codec::ZSTD) == "zstd" && codec->choiceNames().size() == 3);
+    parser.parseCmd({"--codec", "zstd", "-mb"});
+    CHECK(codec->value() == Codec::ZSTD && codec->isSet() && mode->value() == 2);
+    parser.reset();
+    const ParseStatus status{parser.tryParseCmd({"--codec=zst"})};
+    CHECK(status.errors().size() == 1 && status.errors()[0].kind == ParseError::INVALID_CHOICE);
+    CHECK(parser.errorMessage(status.errors()[0]).find("lz4") != std::string::npos);
+    CHECK(codec->value() == Codec::NONE);
+    CHECK(parser.createHelpMessage().find("zstd") != std::string::npos);
+}
+
+TEST(invalidChoices) {
+    ArgParser parser;
+    CHECK_THROWS(std::invalid_argument, parser.add<ChoiceArg<int>>("x", "", "d",
+        ChoiceArg<int>::Choices{{"a", 1}, {"a", 2}}));
+    CHECK_THROWS(std::invalid_argument, parser.add<ChoiceArg<int>>("y", "", "d",
+        ChoiceArg<int>::Choices{{"a", 1}}, 5));
+}
+
+TEST(manyChoices) {
+    ChoiceArg<int>::Choices choices;
+    for (int i = 0; i < 500; ++i) choices.emplace_back("choice-" + std::to_string(i), i);
+    ArgParser parser;
+    auto choice = parser.add<ChoiceArg<int>>("c", "choice", "d", choices, 7);
+    for (int i = 0; i < 500; i += 37) {
+        parser.reset();
+        const std::string name{"choice-" + std::to_string(i)};
+        parser.parseCmd({"-c", StringView{name}});
+        CHECK(choice->value() == i);
+    }
+    parser.reset();
+    CHECK(!parser.tryParseCmd({"-c", "choice-500"}).ok());
+}